@@ -1,39 +1,18 @@
-QT       += core gui
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-CONFIG += c++17
-
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-    Frame.cpp \
-    Pixel.cpp \
-    Popup.cpp \
-    main.cpp \
-    model.cpp \
-    view.cpp
-
-HEADERS += \
-    Frame.h \
-    Pixel.h \
-    Popup.h \
-    gif.h \
-    model.h \
-    view.h
-
-FORMS += \
-    view.ui
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
+TEMPLATE = subdirs
+
+# core is the editing engine as a static library using QtCore and QtGui only,
+# so it runs without a display. app is the Qt Widgets editor built on it, and
+# bench times the engine; run it with "-o results.xml,xml" for parseable output.
+# tests holds the engine's unit tests, run by "make check".
+SUBDIRS += \
+    core \
+    app \
+    bench \
+    tests
+
+app.depends = core
+bench.depends = core
+tests.depends = core
 
 DISTFILES += \
     README
-
-RESOURCES += \
-    icons.qrc
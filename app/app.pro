@@ -0,0 +1,27 @@
+TARGET = Sprite_Editor
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+include(../core/core.pri)
+
+SOURCES += \
+    Popup.cpp \
+    main.cpp \
+    view.cpp
+
+HEADERS += \
+    Popup.h \
+    view.h
+
+FORMS += \
+    view.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+RESOURCES += \
+    icons.qrc
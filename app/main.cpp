@@ -0,0 +1,20 @@
+#include "Batch.h"
+#include "model.h"
+#include "view.h"
+
+#include <QApplication>
+#include <QCoreApplication>
+
+int main(int argc, char *argv[]) {
+  // Batch exports run without a display, so they mustn't create any widgets.
+  if (Batch::requested(argc, argv)) {
+    QCoreApplication app(argc, argv);
+    return Batch::run(app.arguments());
+  }
+
+  QApplication app(argc, argv);
+  Model model;
+  View view(model);
+  view.show();
+  return app.exec();
+}
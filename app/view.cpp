@@ -4,9 +4,12 @@
  **/
 
 #include "view.h"
+#include "Import.h"
 #include "ui_view.h"
 #include <QApplication>
+#include <QColorDialog>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QMessageBox>
 #include <QMouseEvent>
 #include <QScrollBar>
@@ -44,6 +47,12 @@ View::View(Model &model, QWidget *parent)
       QString("QSpinBox {background-color: rgb(255, 255, 255);color: black;}"));
   ui->OpacityBox->setStyleSheet(
       QString("QSpinBox {background-color: rgb(255, 255, 255);color: black;}"));
+  ui->SetBrushSize->setStyleSheet(QString(
+      "QTextEdit {background-color: rgb(255, 255, 255); color: black;}"));
+  ui->BrushSizeBox->setStyleSheet(
+      QString("QSpinBox {background-color: rgb(255, 255, 255);color: black;}"));
+  ui->BrushShapeBox->setStyleSheet(
+      QString("QComboBox {background-color: rgb(255, 255, 255);color: black;}"));
   ui->ImageEditor->setScaledContents(true);
   ui->ImageEditor->setStyleSheet(QString("QFrame {border: 1px solid white;}"));
   appendANewFrameOnUi();
@@ -99,7 +108,7 @@ View::View(Model &model, QWidget *parent)
   connect(this, &View::viewMouseClick, &model, &Model::mousePressed);
   connect(this, &View::viewMouseMovement, &model, &Model::mouseMove);
   connect(this, &View::viewMouseReleaseEvent, &model, &Model::mouseReleased);
-  connect(&model, &Model::setImageEditor, ui->ImageEditor, &QLabel::setPixmap);
+  connect(&model, &Model::setImageEditor, this, &View::showImageEditor);
   connect(&model, &Model::setImageEditor, this, &View::frameMenuPreview);
 
   // Toolbar Connections
@@ -109,6 +118,14 @@ View::View(Model &model, QWidget *parent)
           &View::savePNGDialog);
   connect(ui->actionGif_Export, &QAction::triggered, this,
           &View::saveGIFDialog);
+  connect(ui->actionAnimated_PNG, &QAction::triggered, this,
+          &View::saveAPNGDialog);
+  connect(ui->actionPNG_Sequence, &QAction::triggered, this,
+          &View::savePNGSequenceDialog);
+  connect(ui->actionSprite_Sheet, &QAction::triggered, this,
+          &View::saveAtlasDialog);
+  connect(ui->actionCancel_Exports, &QAction::triggered, &model.exports,
+          &ExportQueue::cancelAll);
   connect(ui->actionDelete_Selected_Layer, &QAction::triggered, &model,
           &Model::deleteSelectedLayer);
   connect(ui->actionMove_Selected_Layer_Down, &QAction::triggered, &model,
@@ -121,14 +138,28 @@ View::View(Model &model, QWidget *parent)
           &View::saveFileDialog);
   connect(ui->LoadProjectAction, &QAction::triggered, this,
           &View::loadFileDialog);
+  connect(ui->actionImport_GIF, &QAction::triggered, this,
+          &View::importGIFDialog);
+  connect(ui->actionImport_Sprite_Sheet, &QAction::triggered, this,
+          &View::importSheetDialog);
+  connect(ui->actionImport_PNG_Sequence, &QAction::triggered, this,
+          &View::importSequenceDialog);
 
   // Color Palette connections
-  connect(ui->CustomColorButton, &QPushButton::clicked, &model,
-          &Model::CustomColorButtonClicked);
-  connect(&model.dialogBox, &QColorDialog::colorSelected, &model,
+  connect(ui->CustomColorButton, &QPushButton::clicked, &colorDialog,
+          &QColorDialog::open);
+  connect(&colorDialog, &QColorDialog::colorSelected, &model,
           &Model::colorSelected);
   connect(ui->OpacityBox, &QSpinBox::valueChanged, &model, &Model::setOpacity);
 
+  // Brush connections
+  connect(ui->BrushSizeBox, &QSpinBox::valueChanged, &model,
+          &Model::setBrushSize);
+  connect(ui->BrushShapeBox, &QComboBox::currentIndexChanged, &model,
+          &Model::setBrushShape);
+  connect(ui->actionLoad_Custom_Brush, &QAction::triggered, this,
+          &View::loadCustomBrushDialog);
+
   // Frame Menu connections
   connect(ui->ScrollLeft, &QPushButton::clicked, &model,
           &Model::leftScrollButtonClicked);
@@ -147,14 +178,68 @@ View::View(Model &model, QWidget *parent)
   connect(ui->actionDuplicate_current_frame, &QAction::triggered, &model,
           &Model::copyFrameClicked);
   connect(&model, &Model::addANewFrameOnUi, this, &View::appendCopyFrameOnUi);
-  connect(this, &View::viewMouseClick, &model, &Model::mousePressed);
+  connect(ui->actionMove_frame_left, &QAction::triggered, &model,
+          &Model::moveFrameLeftClicked);
+  connect(ui->actionMove_frame_right, &QAction::triggered, &model,
+          &Model::moveFrameRightClicked);
+  connect(&model, &Model::framesChanged, this, &View::refreshFrameMenu);
+
+  // Edit menu connections
+  connect(ui->actionUndo, &QAction::triggered, &model, &Model::undo);
+  connect(ui->actionRedo, &QAction::triggered, &model, &Model::redo);
+
+  // Select menu connections
+  connect(ui->actionRectangle_Select, &QAction::triggered, &model,
+          &Model::rectSelectClicked);
+  connect(ui->actionLasso_Select, &QAction::triggered, &model,
+          &Model::lassoSelectClicked);
+  connect(ui->actionMagic_Wand, &QAction::triggered, &model,
+          &Model::magicWandClicked);
+  connect(ui->actionSelect_All, &QAction::triggered, &model,
+          &Model::selectAll);
+  connect(ui->actionDeselect, &QAction::triggered, &model, &Model::deselect);
+  connect(ui->actionInvert_Selection, &QAction::triggered, &model,
+          &Model::invertSelection);
+  connect(ui->actionFlip_Horizontal, &QAction::triggered, &model,
+          &Model::flipSelectionHorizontal);
+  connect(ui->actionFlip_Vertical, &QAction::triggered, &model,
+          &Model::flipSelectionVertical);
+  connect(ui->actionRotate_Clockwise, &QAction::triggered, &model,
+          &Model::rotateSelection);
+
+  // Palette menu connections
+  connect(ui->actionConvert_to_Indexed_Color, &QAction::triggered, this,
+          &View::convertToIndexedDialog);
+  connect(ui->actionConvert_to_True_Color, &QAction::triggered, &model,
+          &Model::convertToTrueColor);
+  connect(ui->actionEdit_Palette_Color, &QAction::triggered, this,
+          &View::editPaletteColorDialog);
 
   // Sprite Preview Menu connections
-  connect(&model, &Model::setPreviewImage, ui->PreviewLabel,
-          &QLabel::setPixmap);
+  connect(&model, &Model::setPreviewImage, this, &View::showPreview);
   connect(ui->FramesPerSecond, &QSpinBox::valueChanged, &model,
           &Model::receiveFrameRate);
 
+  // Export progress
+  exportProgress = new QProgressBar();
+  exportProgress->setMaximumWidth(200);
+  exportProgress->hide();
+  ui->statusbar->addPermanentWidget(exportProgress);
+  connect(&model.exports, &ExportQueue::progress, this,
+          &View::showExportProgress);
+  connect(&model.exports, &ExportQueue::finished, this,
+          &View::exportFinished);
+
+  // Memory readout, refreshed every second
+  memoryReadout = new QLabel();
+  ui->statusbar->addPermanentWidget(memoryReadout);
+  memoryTimer.setInterval(1000);
+  connect(&memoryTimer, &QTimer::timeout, this, &View::updateMemoryReadout);
+  memoryTimer.start();
+  updateMemoryReadout();
+  connect(ui->actionMemory_Report, &QAction::triggered, this,
+          &View::showMemoryReport);
+
   // Frame size popup
   frameSizePopup = new Popup(*m);
   frameSizePopup->hide();
@@ -197,6 +282,71 @@ void View::loadFileDialog() {
   }
 }
 
+///
+/// \brief pop up a file dialog to replace the project with the frames of a
+/// GIF
+///
+void View::importGIFDialog() {
+  QString fileName = QFileDialog::getOpenFileName(
+      this, tr("Import GIF"), "", tr("GIF Files (*.gif);;All Files (*)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  if (!m->importGIF(fileName)) {
+    ui->statusbar->showMessage("Couldn't import " + fileName);
+  }
+}
+
+///
+/// \brief pop up dialogs to replace the project with the frames of a sprite
+/// sheet, either described by a json atlas or cut into tiles of a given size
+///
+void View::importSheetDialog() {
+  QString fileName = QFileDialog::getOpenFileName(
+      this, tr("Import Sprite Sheet"), "",
+      tr("Sprite Sheets (*.png *.json);;All Files (*)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  QVector<QImage> images;
+  if (fileName.endsWith(".json", Qt::CaseInsensitive)) {
+    images = Import::readAtlas(fileName);
+  } else {
+    bool ok;
+    int tileWidth = QInputDialog::getInt(this, tr("Tile Size"),
+                                         tr("Tile width:"), 16, 1, 4096, 1,
+                                         &ok);
+    if (!ok) {
+      return;
+    }
+    int tileHeight = QInputDialog::getInt(this, tr("Tile Size"),
+                                          tr("Tile height:"), tileWidth, 1,
+                                          4096, 1, &ok);
+    if (!ok) {
+      return;
+    }
+    images = Import::readGrid(fileName, QSize(tileWidth, tileHeight));
+  }
+  if (!m->importImages(images)) {
+    ui->statusbar->showMessage("Couldn't import " + fileName);
+  }
+}
+
+///
+/// \brief pop up a directory dialog to replace the project with the pngs in
+/// a directory, one frame each
+///
+void View::importSequenceDialog() {
+  QString directory =
+      QFileDialog::getExistingDirectory(this, tr("Import PNG Sequence"));
+  if (directory.isEmpty()) {
+    return;
+  }
+  if (!m->importImages(Import::readSequence(directory))) {
+    ui->statusbar->showMessage("Couldn't import the pngs in " + directory);
+  }
+}
+
 ///
 /// \brief pop up a file dialog to save current project to GIF file
 ///
@@ -206,8 +356,23 @@ void View::saveGIFDialog() {
   if (fileName.isEmpty()) {
     return;
   } else {
-    // write data to file...
-    m->saveGIF(fileName);
+    bool ok;
+    int scale = QInputDialog::getInt(this, tr("Export Scale"), tr("Scale:"), 1,
+                                     1, Export::maxScale, 1, &ok);
+    if (!ok) {
+      return;
+    }
+    // in the order of Export::Dither
+    QStringList modes{tr("None"), tr("Floyd-Steinberg (slow)"),
+                      tr("Ordered (fast)")};
+    QString mode = QInputDialog::getItem(this, tr("Export Dithering"),
+                                         tr("Dithering:"), modes, 0, false,
+                                         &ok);
+    if (!ok) {
+      return;
+    }
+    // write data to file in the background
+    m->exportGIF(fileName, scale, Export::Dither(modes.indexOf(mode)));
   }
 }
 
@@ -220,11 +385,205 @@ void View::savePNGDialog() {
   if (fileName.isEmpty()) {
     return;
   } else {
-    // write data to file...
-    m->savePNG(fileName);
+    bool ok;
+    int scale = QInputDialog::getInt(this, tr("Export Scale"), tr("Scale:"), 1,
+                                     1, Export::maxScale, 1, &ok);
+    if (!ok) {
+      return;
+    }
+    // write data to file in the background
+    m->exportPNG(fileName, scale);
   }
 }
 
+///
+/// \brief pop up a file dialog to save the frames to an animated PNG
+///
+void View::saveAPNGDialog() {
+  QString fileName = QFileDialog::getSaveFileName(
+      this, tr("Save Animated PNG"), "",
+      tr("PNG Files (*.png);;All Files (*)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  bool ok;
+  int scale = QInputDialog::getInt(this, tr("Export Scale"), tr("Scale:"), 1,
+                                   1, Export::maxScale, 1, &ok);
+  if (!ok) {
+    return;
+  }
+  // write data to file in the background
+  m->exportAPNG(fileName, scale);
+}
+
+///
+/// \brief pop up dialogs to save every frame, or every layer of every frame,
+/// to numbered PNG files
+///
+void View::savePNGSequenceDialog() {
+  QString fileName = QFileDialog::getSaveFileName(
+      this, tr("Save PNG Sequence"), "",
+      tr("PNG Files (*.png);;All Files (*)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  bool ok;
+  int scale = QInputDialog::getInt(this, tr("Export Scale"), tr("Scale:"), 1,
+                                   1, Export::maxScale, 1, &ok);
+  if (!ok) {
+    return;
+  }
+  QStringList contents = {tr("Frames"), tr("Every layer of every frame")};
+  QString content = QInputDialog::getItem(this, tr("Export Contents"),
+                                          tr("Export:"), contents, 0, false,
+                                          &ok);
+  if (!ok) {
+    return;
+  }
+  int level = QInputDialog::getInt(this, tr("Export Compression"),
+                                   tr("Compression (0 fastest, 9 smallest):"),
+                                   6, 0, 9, 1, &ok);
+  if (!ok) {
+    return;
+  }
+  QStringList formats = {tr("RGBA"), tr("Palette if 256 colors or fewer")};
+  QString format = QInputDialog::getItem(this, tr("Export Format"),
+                                         tr("Format:"), formats, 1, false,
+                                         &ok);
+  if (!ok) {
+    return;
+  }
+  // write data to files in the background
+  m->exportPNGSequence(fileName, scale, content == contents[1], level,
+                       format == formats[1]);
+}
+
+///
+/// \brief pop up file dialogs to save the frames, and optionally those of
+/// other saved projects, to a sprite sheet
+///
+void View::saveAtlasDialog() {
+  QString fileName =
+      QFileDialog::getSaveFileName(this, tr("Save Sprite Sheet"), "",
+                                   tr("PNG Files (*.png);;All Files (*)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  // cancelling this one packs only the current project
+  QStringList otherProjects = QFileDialog::getOpenFileNames(
+      this, tr("Add Other Projects"), "",
+      tr("Json Files (*.ssp);;All Files (*)"));
+  // write data to file in the background
+  m->exportAtlas(fileName, otherProjects);
+}
+
+///
+/// \brief shows how far the running export is in the status bar
+/// \param job The export job
+/// \param done Frames written so far
+/// \param total Frames in the export
+///
+void View::showExportProgress(int job, int done, int total) {
+  exportProgress->setRange(0, total);
+  exportProgress->setValue(done);
+  exportProgress->show();
+  ui->statusbar->showMessage(
+      QString("Exporting (job %1, %2 queued)...")
+          .arg(job)
+          .arg(m->exports.pendingJobs() - 1));
+}
+
+///
+/// \brief reports a finished export in the status bar
+/// \param job The export job
+/// \param fileName The file it wrote
+/// \param saved false if the export failed or was cancelled
+///
+void View::exportFinished(int job, const QString &fileName, bool saved) {
+  Q_UNUSED(job);
+  if (m->exports.pendingJobs() == 0) {
+    exportProgress->hide();
+  }
+  ui->statusbar->showMessage(saved ? "Exported " + fileName
+                                   : "Export of " + fileName +
+                                         " was cancelled or failed",
+                             5000);
+}
+
+///
+/// \brief pop up a file dialog to pick the bitmap of the custom brush
+///
+void View::loadCustomBrushDialog() {
+  QString fileName = QFileDialog::getOpenFileName(
+      this, tr("Load Custom Brush"), "",
+      tr("Image Files (*.png *.bmp *.gif);;All Files (*)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  QImage mask(fileName);
+  if (mask.isNull()) {
+    QMessageBox::information(nullptr, "Warning Message",
+                             "The brush image could not be read.");
+    return;
+  }
+  m->setCustomBrush(mask);
+  ui->BrushShapeBox->setCurrentIndex(Brush::custom);
+}
+
+///
+/// \brief converts the project to indexed color, warning if it has too many
+/// colors for a palette
+///
+void View::convertToIndexedDialog() {
+  if (!m->convertToIndexed()) {
+    QMessageBox::information(nullptr, "Warning Message",
+                             "The project uses more colors than a palette "
+                             "can hold.");
+  }
+}
+
+///
+/// \brief asks for a palette index and its new color, recoloring every pixel
+/// that uses it
+///
+void View::editPaletteColorDialog() {
+  const Palette &palette = m->getPalette();
+  if (!m->isIndexed() || palette.size() < 2) {
+    QMessageBox::information(nullptr, "Warning Message",
+                             "The palette has no colors to edit.");
+    return;
+  }
+  bool ok;
+  int index = QInputDialog::getInt(this, tr("Edit Palette Color"),
+                                   tr("Palette index:"), 1, 1,
+                                   palette.size() - 1, 1, &ok);
+  if (!ok) {
+    return;
+  }
+  QColor color = QColorDialog::getColor(
+      QColor::fromRgba(palette.color(index)), this, tr("Palette Color"),
+      QColorDialog::ShowAlphaChannel);
+  if (color.isValid()) {
+    m->setPaletteColor(index, color);
+  }
+}
+
+///
+/// \brief View::showImageEditor shows the editing window image from the model
+/// \param image The current layer, scaled to the editor
+///
+void View::showImageEditor(const QImage &image) {
+  ui->ImageEditor->setPixmap(QPixmap::fromImage(image));
+}
+
+///
+/// \brief View::showPreview shows the animation preview frame from the model
+/// \param image The composited frame, scaled to the preview
+///
+void View::showPreview(const QImage &image) {
+  ui->PreviewLabel->setPixmap(QPixmap::fromImage(image));
+}
+
 ///
 /// \brief update the preview of current frame on frame menu
 ///
@@ -261,6 +620,48 @@ void View::highlightFrameInFrameMenu(int idx) {
       "QLabel {border: 5px solid red;}");
 }
 
+///
+/// \brief measures the memory held by the project and by the pixmaps showing
+/// it
+/// \param findDuplicates Also look for identical but unshared layers
+/// \return The report
+///
+MemoryReport View::measureMemory(bool findDuplicates) {
+  MemoryReport report = m->memoryReport(findDuplicates);
+  QVector<QLabel *> labels = frameLabels;
+  labels << ui->ImageEditor << ui->PreviewLabel;
+  for (QLabel *label : labels) {
+    QPixmap pixmap = label->pixmap();
+    report.displayBytes +=
+        qsizetype(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+  }
+  return report;
+}
+
+///
+/// \brief shows the memory the project holds in the status bar, with the
+/// breakdown in its tooltip
+///
+void View::updateMemoryReadout() {
+  MemoryReport report = measureMemory(false);
+  memoryReadout->setText(
+      QString("Memory: %1").arg(MemoryReport::formatBytes(report.total())));
+  memoryReadout->setToolTip(report.summary());
+}
+
+///
+/// \brief shows the memory held by every frame and layer, and also prints it
+/// for bug reports
+///
+void View::showMemoryReport() {
+  MemoryReport report = measureMemory(true);
+  qInfo("%s", qPrintable(report.details()));
+  QMessageBox box(QMessageBox::Information, tr("Memory Report"),
+                  report.summary(), QMessageBox::Ok, this);
+  box.setDetailedText(report.details());
+  box.exec();
+}
+
 ///
 /// \brief poping up a warning message when user try to delete the last frame of
 /// a project
@@ -325,6 +726,25 @@ void View::removeFrameOnUi() {
   }
 }
 
+///
+/// \brief View::refreshFrameMenu - rebuilds the frame menu from the model's
+/// frames, used after edits that can change frames anywhere in the list
+///
+void View::refreshFrameMenu() {
+  while (frameLabels.size() < (qsizetype)m->frames.size()) {
+    appendANewFrameOnUi();
+  }
+  while (frameLabels.size() > (qsizetype)m->frames.size()) {
+    QLabel *frame = frameLabels.takeLast();
+    ui->scrollAreaWidgetContents_2->layout()->removeWidget(frame);
+    delete frame;
+  }
+  for (qsizetype i = 0; i < frameLabels.size(); i++) {
+    frameLabels[i]->setPixmap(
+        QPixmap::fromImage(m->frames[i]->getComposite().scaled(89, 89)));
+  }
+}
+
 ///
 /// \brief View::showFrameSizePopup - shows the frame size popup
 ///
@@ -4,9 +4,12 @@
 #include "Popup.h"
 #include "model.h"
 #include <QCheckBox>
+#include <QColorDialog>
 #include <QFrame>
 #include <QLabel>
 #include <QMainWindow>
+#include <QProgressBar>
+#include <QTimer>
 #include <QVBoxLayout>
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -49,6 +52,12 @@ private slots:
   void selectLayer(QMouseEvent *);
   void boxChecked(bool);
   void showFrameSizePopup();
+  void showImageEditor(const QImage &image);
+  void showPreview(const QImage &image);
+  void showExportProgress(int job, int done, int total);
+  void exportFinished(int job, const QString &fileName, bool saved);
+  void updateMemoryReadout();
+  void showMemoryReport();
 
 protected:
   virtual void mousePressEvent(QMouseEvent *event) override;
@@ -58,19 +67,34 @@ protected:
 private:
   Ui::View *ui;
   QVBoxLayout *layerLayout;
+  QColorDialog colorDialog;
+  QProgressBar *exportProgress; // shown in the status bar while exporting
+  QLabel *memoryReadout;        // project memory, in the status bar
+  QTimer memoryTimer;           // refreshes memoryReadout
+  MemoryReport measureMemory(bool findDuplicates);
   QVector<layerFrame> layerFrames;
 
   QVector<QLabel *> frameLabels;
   void appendANewFrameOnUi();
   void removeFrameOnUi();
+  void refreshFrameMenu();
   void appendCopyFrameOnUi();
   void highlightFrameInFrameMenu(int);
   void CanNotDeleteFrameWarningMessageBox();
   void saveFileDialog();
   void loadFileDialog();
+  void importGIFDialog();
+  void importSheetDialog();
+  void importSequenceDialog();
   void frameMenuPreview();
   void savePNGDialog();
   void saveGIFDialog();
+  void saveAPNGDialog();
+  void savePNGSequenceDialog();
+  void saveAtlasDialog();
+  void loadCustomBrushDialog();
+  void convertToIndexedDialog();
+  void editPaletteColorDialog();
   void setSelectedLayer(int);
 };
 
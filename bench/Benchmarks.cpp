@@ -0,0 +1,389 @@
+#include "Frame.h"
+#include "model.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMouseEvent>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <functional>
+
+///
+/// \brief The Benchmarks class times the core editing paths: compositing,
+/// the pen, eraser and bucket as driven by the mouse, frame and project
+/// (de)serialization and gif export, over a range of canvas, layer and frame
+/// counts. It needs no display. For results a script can read, run it with
+/// a QtTest logger, e.g. "bench -o results.xml,xml" or "bench -csv".
+///
+class Benchmarks : public QObject {
+  Q_OBJECT
+
+private slots:
+  void composite_data();
+  void composite();
+  void pen_data();
+  void pen();
+  void eraser_data();
+  void eraser();
+  void bucket_data();
+  void bucket();
+  void frameWrite_data();
+  void frameWrite();
+  void frameRead_data();
+  void frameRead();
+  void saveProject_data();
+  void saveProject();
+  void loadProject_data();
+  void loadProject();
+  void saveGIF_data();
+  void saveGIF();
+
+private:
+  // The colors of a built project. A gradient has thousands of colors, so the
+  // gif encoder quantizes every frame; a sprite has a few, mapped exactly;
+  // mixed alternates the two.
+  enum Colors { gradient, sprite, mixed };
+
+  static void addSizes();
+  static void addStrokes();
+  static void addProjects(bool withSample);
+  static void buildProject(Model &model, int size, int frames, int layers,
+                           Colors colors = gradient);
+  static void send(Model &model, QEvent::Type type, QPointF position);
+  static void drag(Model &model, bool batched);
+  static void measureEdits(Model &model, const std::function<void()> &edit);
+
+  QTemporaryDir scratch;
+};
+
+// Canvas sides, from the default project size up to the largest supported
+static const int canvasSizes[] = {8, 32, 128, 512, 1024};
+
+///
+/// \brief Benchmarks::addSizes adds a "size" column with a row per canvas
+///
+void Benchmarks::addSizes() {
+  QTest::addColumn<int>("size");
+  for (int size : canvasSizes) {
+    QTest::addRow("%dpx", size) << size;
+  }
+}
+
+///
+/// \brief Benchmarks::addStrokes adds the "size" and "batched" columns, with
+/// a row per canvas for each way the editor applies stroke samples
+///
+void Benchmarks::addStrokes() {
+  QTest::addColumn<int>("size");
+  QTest::addColumn<bool>("batched");
+  for (bool batched : {false, true}) {
+    for (int size : canvasSizes) {
+      QTest::addRow("%dpx %s", size, batched ? "one batch" : "per sample")
+          << size << batched;
+    }
+  }
+}
+
+///
+/// \brief Benchmarks::addProjects adds rows for single frames of every canvas
+/// size, for longer animations on a mid-sized canvas, and optionally for the
+/// sample project shipped with the editor
+/// \param withSample Add a row loading smile.ssp
+///
+void Benchmarks::addProjects(bool withSample) {
+  QTest::addColumn<int>("size");
+  QTest::addColumn<int>("frames");
+  QTest::addColumn<QString>("sample");
+  for (int size : canvasSizes) {
+    QTest::addRow("%dpx 1 frame", size) << size << 1 << QString();
+  }
+  for (int frames : {8, 32}) {
+    QTest::addRow("64px %d frames", frames) << 64 << frames << QString();
+  }
+  if (withSample) {
+    QTest::newRow("smile.ssp") << 0 << 0 << QFINDTESTDATA("../smile.ssp");
+  }
+}
+
+///
+/// \brief Benchmarks::buildProject replaces the project with frames whose
+/// layers hold a repeatable pattern. The bottom layer is opaque and the ones
+/// above it are mostly transparent, so compositing blends as in a real sprite,
+/// and each frame differs so that animations aren't merged away.
+/// \param model The project to replace
+/// \param size The canvas side
+/// \param frames The number of frames
+/// \param layers The number of layers in each frame
+/// \param colors Whether frames blend a gradient or use a 16 color palette
+/// without translucency, as pixel art does
+///
+void Benchmarks::buildProject(Model &model, int size, int frames, int layers,
+                              Colors colors) {
+  model.setSize(size);
+  for (int i = 1; i < layers; i++) {
+    model.addBlankLayer();
+  }
+  for (int i = 1; i < frames; i++) {
+    model.copyFrameClicked();
+  }
+  for (int f = 0; f < (int)model.frames.size(); f++) {
+    LayerList &frameLayers = model.frames[f]->layers;
+    int bottom = frameLayers.size() - 1;
+    bool few = colors == sprite || (colors == mixed && f % 2 == 0);
+    for (int l = 0; l <= bottom; l++) {
+      QImage &image = frameLayers[l]->image;
+      for (int y = 0; y < size; y++) {
+        QRgb *pixels = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size; x++) {
+          bool covered = l == bottom || (x + y + f) % (l + 2) == 0;
+          if (few) {
+            int index = (x / 4 + y / 4 + f + l) % 16;
+            pixels[x] = covered ? qRgb(index * 16, 255 - index * 8,
+                                       (index * 53) & 255)
+                                : 0;
+            continue;
+          }
+          int alpha = covered ? ((x ^ y) % 3 == 0 ? 128 : 255) : 0;
+          pixels[x] = qPremultiply(qRgba((x * 7 + f * 13) & 255,
+                                         (y * 5 + l * 29) & 255, (x ^ y) & 255,
+                                         alpha));
+        }
+      }
+    }
+  }
+}
+
+///
+/// \brief Benchmarks::send delivers a mouse event to the model as the view does
+/// \param model
+/// \param type Press, move or release
+/// \param position In window coordinates; the editor spans (410, 30) to
+/// (890, 510)
+///
+void Benchmarks::send(Model &model, QEvent::Type type, QPointF position) {
+  Qt::MouseButtons buttons =
+      type == QEvent::MouseButtonRelease ? Qt::NoButton : Qt::LeftButton;
+  QMouseEvent event(type, position, position, Qt::LeftButton, buttons,
+                    Qt::NoModifier);
+  switch (type) {
+  case QEvent::MouseButtonPress:
+    model.mousePressed(&event);
+    break;
+  case QEvent::MouseMove:
+    model.mouseMove(&event);
+    break;
+  default:
+    model.mouseReleased(&event);
+    break;
+  }
+}
+
+///
+/// \brief Benchmarks::drag draws one diagonal stroke across the editor with
+/// the current tool, sampled every four window pixels like a quick drag.
+/// The model queues samples and applies them from a zero-interval timer, so
+/// how many land in one batch depends on the event loop.
+/// \param model
+/// \param batched Queue every sample until the release, as when the mouse
+/// outpaces the editor; otherwise run the event loop after each move so the
+/// timer applies it on its own, as when the editor keeps up
+///
+void Benchmarks::drag(Model &model, bool batched) {
+  send(model, QEvent::MouseButtonPress, QPointF(411, 31));
+  for (int offset = 4; offset < 478; offset += 4) {
+    send(model, QEvent::MouseMove, QPointF(411 + offset, 31 + offset));
+    if (!batched) {
+      QCoreApplication::processEvents();
+    }
+  }
+  send(model, QEvent::MouseButtonRelease, QPointF(889, 509));
+}
+
+///
+/// \brief Benchmarks::measureEdits times an edit repeated on the same layer.
+/// Each edit adds to the undo history, which compresses older entries once
+/// it is large, so the history is cleared before every edit, outside the
+/// timing, and each one starts from the same state.
+/// \param model
+/// \param edit One complete edit, from press to release
+///
+void Benchmarks::measureEdits(Model &model,
+                              const std::function<void()> &edit) {
+  const int edits = 20;
+  qint64 elapsed = 0;
+  QElapsedTimer timer;
+  for (int i = 0; i < edits; i++) {
+    model.clearHistory();
+    timer.start();
+    edit();
+    elapsed += timer.nsecsElapsed();
+  }
+  QTest::setBenchmarkResult(elapsed / 1e6 / edits,
+                            QTest::WalltimeMilliseconds);
+}
+
+void Benchmarks::composite_data() {
+  QTest::addColumn<int>("size");
+  QTest::addColumn<int>("layers");
+  for (int size : canvasSizes) {
+    for (int layers : {1, 4, 16}) {
+      QTest::addRow("%dpx %d layers", size, layers) << size << layers;
+    }
+  }
+}
+
+void Benchmarks::composite() {
+  QFETCH(int, size);
+  QFETCH(int, layers);
+  Model model;
+  buildProject(model, size, 1, layers);
+  Frame &frame = *model.frames[0];
+  QImage image;
+  QBENCHMARK { image = frame.getComposite(); }
+}
+
+void Benchmarks::pen_data() { addStrokes(); }
+
+void Benchmarks::pen() {
+  QFETCH(int, size);
+  QFETCH(bool, batched);
+  Model model;
+  buildProject(model, size, 1, 1);
+  model.penButtonClicked();
+  measureEdits(model, [&] { drag(model, batched); });
+}
+
+void Benchmarks::eraser_data() { addStrokes(); }
+
+void Benchmarks::eraser() {
+  QFETCH(int, size);
+  QFETCH(bool, batched);
+  Model model;
+  buildProject(model, size, 1, 1);
+  model.eraserButtonClicked();
+  measureEdits(model, [&] { drag(model, batched); });
+}
+
+void Benchmarks::bucket_data() { addSizes(); }
+
+void Benchmarks::bucket() {
+  QFETCH(int, size);
+  Model model;
+  buildProject(model, size, 1, 1);
+  model.bucketButtonClicked();
+  measureEdits(model, [&] {
+    send(model, QEvent::MouseButtonPress, QPointF(650, 270));
+    send(model, QEvent::MouseButtonRelease, QPointF(650, 270));
+  });
+}
+
+void Benchmarks::frameWrite_data() { addSizes(); }
+
+void Benchmarks::frameWrite() {
+  QFETCH(int, size);
+  Model model;
+  buildProject(model, size, 1, 4);
+  QBENCHMARK {
+    QJsonObject json;
+    model.frames[0]->write(json);
+  }
+}
+
+void Benchmarks::frameRead_data() { addSizes(); }
+
+void Benchmarks::frameRead() {
+  QFETCH(int, size);
+  Model model;
+  buildProject(model, size, 1, 4);
+  QJsonObject json;
+  model.frames[0]->write(json);
+  Frame frame(size);
+  QBENCHMARK { frame.read(json); }
+}
+
+void Benchmarks::saveProject_data() { addProjects(false); }
+
+void Benchmarks::saveProject() {
+  QFETCH(int, size);
+  QFETCH(int, frames);
+  Model model;
+  buildProject(model, size, frames, 4);
+  QString fileName = scratch.filePath("save.ssp");
+  QBENCHMARK { model.saveProject(fileName); }
+}
+
+void Benchmarks::loadProject_data() { addProjects(true); }
+
+void Benchmarks::loadProject() {
+  QFETCH(int, size);
+  QFETCH(int, frames);
+  QFETCH(QString, sample);
+  Model model;
+  QString fileName = sample;
+  if (fileName.isEmpty()) {
+    buildProject(model, size, frames, 4);
+    fileName = scratch.filePath("load.ssp");
+    model.saveProject(fileName);
+  }
+  QVERIFY(QFile::exists(fileName));
+  QBENCHMARK { model.loadProject(fileName); }
+}
+
+///
+/// \brief Benchmarks::saveGIF_data runs every gif export twice, once encoding
+/// the frames on the calling thread and once on the thread pool, and adds
+/// animations of up to 1000 frames where the parallel encoder pays off. The
+/// animations are quantized gradients, sprites the encoder maps exactly, and a
+/// mix of both.
+///
+void Benchmarks::saveGIF_data() {
+  QTest::addColumn<int>("size");
+  QTest::addColumn<int>("frames");
+  QTest::addColumn<int>("colors");
+  QTest::addColumn<QString>("sample");
+  QTest::addColumn<bool>("parallel");
+  const char *names[] = {"gradient", "sprite", "mixed"};
+  for (bool parallel : {false, true}) {
+    const char *mode = parallel ? "parallel" : "serial";
+    for (int size : canvasSizes) {
+      QTest::addRow("%dpx 1 frame %s", size, mode)
+          << size << 1 << int(gradient) << QString() << parallel;
+    }
+    for (Colors colors : {gradient, sprite, mixed}) {
+      for (int frames : {8, 32, 100, 300, 1000}) {
+        QTest::addRow("64px %d frames %s %s", frames, names[colors], mode)
+            << 64 << frames << int(colors) << QString() << parallel;
+      }
+    }
+    QTest::addRow("smile.ssp %s", mode)
+        << 0 << 0 << int(sprite) << QFINDTESTDATA("../smile.ssp") << parallel;
+  }
+}
+
+void Benchmarks::saveGIF() {
+  QFETCH(int, size);
+  QFETCH(int, frames);
+  QFETCH(int, colors);
+  QFETCH(QString, sample);
+  QFETCH(bool, parallel);
+  Model model;
+  if (sample.isEmpty()) {
+    buildProject(model, size, frames, 4, Colors(colors));
+  } else {
+    QVERIFY(QFile::exists(sample));
+    model.loadProject(sample);
+  }
+  QString fileName = scratch.filePath("export.gif");
+  QBENCHMARK { QVERIFY(model.saveGIF(fileName, parallel)); }
+
+  // The two encoders must write the same file byte for byte.
+  QString otherName = scratch.filePath("other.gif");
+  QVERIFY(model.saveGIF(otherName, !parallel));
+  QFile file(fileName);
+  QFile other(otherName);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QVERIFY(other.open(QIODevice::ReadOnly));
+  QCOMPARE(file.readAll(), other.readAll());
+}
+
+QTEST_GUILESS_MAIN(Benchmarks)
+#include "Benchmarks.moc"
@@ -0,0 +1,12 @@
+TARGET = bench
+
+# Runs without a display, like the core library it measures.
+QT = core gui testlib
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../core/core.pri)
+
+SOURCES += \
+    Benchmarks.cpp
@@ -0,0 +1,367 @@
+#include "Atlas.h"
+#include "Export.h"
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <numeric>
+
+///
+/// \brief Atlas::save packs sprites into a sheet and writes it as a png, with
+/// its description next to it as a json file of the same name. Trimming,
+/// hashing and blitting run on the global thread pool, as do packing attempts
+/// for several sheet sizes, of which the smallest that fits is kept.
+/// \param sprites Named frames, in animation order
+/// \param fileName The png to write
+/// \param options
+/// \param progress Told about every sprite blitted, can cancel the export
+/// \return true if both files were written
+///
+bool Atlas::save(const QVector<Sprite> &sprites, const QString &fileName,
+                 const AtlasOptions &options,
+                 const Progress &progress) {
+  int count = sprites.size();
+  if (count == 0) {
+    return false;
+  }
+
+  // Trim and hash every frame.
+  std::vector<QImage> images(count);
+  std::vector<QRect> bounds(count);
+  std::vector<size_t> hashes(count);
+  std::vector<int> indices(count);
+  std::iota(indices.begin(), indices.end(), 0);
+  QtConcurrent::blockingMap(indices, [&](int i) {
+    QImage image = sprites[i].image.convertToFormat(QImage::Format_RGBA8888);
+    QRect rect = options.trim ? opaqueBounds(image) : image.rect();
+    if (rect.isEmpty()) {
+      rect = QRect(0, 0, 1, 1); // a blank frame keeps one transparent pixel
+    }
+    size_t hash = qHash(rect.width()) ^ qHash(rect.height());
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+      hash = qHashBits(image.constScanLine(y) + rect.left() * 4,
+                       rect.width() * 4, hash);
+    }
+    images[i] = image;
+    bounds[i] = rect;
+    hashes[i] = hash;
+  });
+
+  // Identical trimmed images are packed once.
+  QVector<Packed> packed;
+  std::vector<int> packedOf(count);
+  QHash<size_t, QVector<int>> byHash;
+  for (int i = 0; i < count; i++) {
+    packedOf[i] = -1;
+    if (options.deduplicate) {
+      for (int p : byHash.value(hashes[i])) {
+        if (samePixels(images[packed[p].sprite], packed[p].trimmed, images[i],
+                       bounds[i])) {
+          packedOf[i] = p;
+          break;
+        }
+      }
+    }
+    if (packedOf[i] < 0) {
+      packedOf[i] = packed.size();
+      byHash[hashes[i]].append(packed.size());
+      packed.append(Packed{i, bounds[i], QPoint()});
+    }
+  }
+
+  // Each sprite takes its size plus the padding on its right and bottom.
+  QVector<QSize> sizes;
+  qint64 area = 0;
+  int widest = 0;
+  int tallest = 0;
+  for (const Packed &p : packed) {
+    QSize size = p.trimmed.size() + QSize(options.padding, options.padding);
+    sizes.append(size);
+    area += qint64(size.width()) * size.height();
+    widest = std::max(widest, size.width());
+    tallest = std::max(tallest, size.height());
+  }
+
+  // Power of two sheet sizes that could hold everything, smallest first. The
+  // sheet is cropped to what is used afterwards.
+  QVector<QSize> candidates;
+  for (int width = 16; width <= 16384; width *= 2) {
+    for (int height = 16; height <= 16384; height *= 2) {
+      if (width + options.padding >= widest &&
+          height + options.padding >= tallest &&
+          qint64(width + options.padding) * (height + options.padding) >=
+              area) {
+        candidates.append(QSize(width, height));
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const QSize &a, const QSize &b) {
+              qint64 areaA = qint64(a.width()) * a.height();
+              qint64 areaB = qint64(b.width()) * b.height();
+              if (areaA != areaB) {
+                return areaA < areaB;
+              }
+              return std::abs(a.width() - a.height()) <
+                     std::abs(b.width() - b.height());
+            });
+
+  QVector<QPoint> positions;
+  constexpr int attempts = 8; // packed at once, one per pool thread
+  for (int first = 0; first < candidates.size() && positions.isEmpty();
+       first += attempts) {
+    int last = std::min<int>(first + attempts, candidates.size());
+    std::vector<int> tries(last - first);
+    std::iota(tries.begin(), tries.end(), first);
+    std::vector<QVector<QPoint>> results(tries.size());
+    QtConcurrent::blockingMap(tries, [&](int i) {
+      QSize bin = candidates[i] + QSize(options.padding, options.padding);
+      if (!pack(sizes, bin, results[i - first])) {
+        results[i - first].clear();
+      }
+    });
+    for (const QVector<QPoint> &result : results) {
+      if (!result.isEmpty()) {
+        positions = result;
+        break;
+      }
+    }
+  }
+  if (positions.isEmpty()) {
+    return false;
+  }
+
+  int sheetWidth = 0;
+  int sheetHeight = 0;
+  for (int p = 0; p < packed.size(); p++) {
+    packed[p].position = positions[p];
+    sheetWidth =
+        std::max(sheetWidth, positions[p].x() + packed[p].trimmed.width());
+    sheetHeight =
+        std::max(sheetHeight, positions[p].y() + packed[p].trimmed.height());
+  }
+
+  // Sprites don't overlap, so they are copied in parallel.
+  QImage sheet(sheetWidth, sheetHeight, QImage::Format_RGBA8888);
+  sheet.fill(Qt::transparent);
+  uchar *bits = sheet.bits();
+  qsizetype bytesPerLine = sheet.bytesPerLine();
+  QAtomicInt done = 0;
+  QAtomicInt cancelled = 0;
+  int total = packed.size() + 1;
+  QtConcurrent::blockingMap(packed, [&](const Packed &p) {
+    if (cancelled.loadRelaxed()) {
+      return;
+    }
+    const QImage &image = images[p.sprite];
+    for (int y = 0; y < p.trimmed.height(); y++) {
+      std::memcpy(bits + (p.position.y() + y) * bytesPerLine +
+                      p.position.x() * 4,
+                  image.constScanLine(p.trimmed.top() + y) +
+                      p.trimmed.left() * 4,
+                  p.trimmed.width() * 4);
+    }
+    if (progress && !progress(done.fetchAndAddRelaxed(1) + 1, total)) {
+      cancelled.storeRelaxed(1);
+    }
+  });
+  if (cancelled.loadRelaxed() || !Export::savePNG(sheet, fileName)) {
+    return false;
+  }
+
+  QJsonArray frames;
+  for (int i = 0; i < count; i++) {
+    const Packed &p = packed[packedOf[i]];
+    QJsonObject frame;
+    frame["filename"] = sprites[i].name;
+    frame["frame"] = QJsonObject{{"x", p.position.x()},
+                                 {"y", p.position.y()},
+                                 {"w", bounds[i].width()},
+                                 {"h", bounds[i].height()}};
+    frame["rotated"] = false;
+    frame["trimmed"] = bounds[i] != images[i].rect();
+    frame["spriteSourceSize"] = QJsonObject{{"x", bounds[i].x()},
+                                            {"y", bounds[i].y()},
+                                            {"w", bounds[i].width()},
+                                            {"h", bounds[i].height()}};
+    frame["sourceSize"] = QJsonObject{{"w", images[i].width()},
+                                      {"h", images[i].height()}};
+    frames.append(frame);
+  }
+  QJsonObject json;
+  json["frames"] = frames;
+  json["meta"] = QJsonObject{
+      {"app", "Sprite Editor"},
+      {"image", QFileInfo(fileName).fileName()},
+      {"format", "RGBA8888"},
+      {"size", QJsonObject{{"w", sheetWidth}, {"h", sheetHeight}}},
+      {"scale", "1"}};
+
+  QFileInfo info(fileName);
+  QSaveFile jsonFile(info.path() + "/" + info.completeBaseName() + ".json");
+  if (!jsonFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  jsonFile.write(QJsonDocument(json).toJson());
+  bool saved = jsonFile.commit();
+  if (progress) {
+    progress(total, total);
+  }
+  return saved;
+}
+
+///
+/// \brief Atlas::opaqueBounds
+/// \param image An RGBA8888 image
+/// \return The smallest rectangle holding every pixel that isn't fully
+/// transparent, or an empty rectangle if there are none
+///
+QRect Atlas::opaqueBounds(const QImage &image) {
+  int left = image.width();
+  int right = -1;
+  int top = -1;
+  int bottom = -1;
+  for (int y = 0; y < image.height(); y++) {
+    const uchar *row = image.constScanLine(y);
+    int first = 0;
+    while (first < image.width() && row[first * 4 + 3] == 0) {
+      first++;
+    }
+    if (first == image.width()) {
+      continue;
+    }
+    int last = image.width() - 1;
+    while (row[last * 4 + 3] == 0) {
+      last--;
+    }
+    left = std::min(left, first);
+    right = std::max(right, last);
+    if (top < 0) {
+      top = y;
+    }
+    bottom = y;
+  }
+  if (top < 0) {
+    return QRect();
+  }
+  return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+///
+/// \brief Atlas::samePixels
+/// \return true if the two rectangles of the RGBA8888 images are identical
+///
+bool Atlas::samePixels(const QImage &a, QRect aRect, const QImage &b,
+                       QRect bRect) {
+  if (aRect.size() != bRect.size()) {
+    return false;
+  }
+  for (int y = 0; y < aRect.height(); y++) {
+    if (std::memcmp(a.constScanLine(aRect.top() + y) + aRect.left() * 4,
+                    b.constScanLine(bRect.top() + y) + bRect.left() * 4,
+                    aRect.width() * 4) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+///
+/// \brief Atlas::pack places rectangles in a bin with the MaxRects algorithm:
+/// the free space is kept as the list of largest empty rectangles, and each
+/// rectangle, largest first, goes where it leaves the shortest leftover side.
+/// \param sizes The rectangles to place
+/// \param bin The space available
+/// \param positions Set to the top left corner of each rectangle
+/// \return false if they don't all fit
+///
+bool Atlas::pack(const QVector<QSize> &sizes, QSize bin,
+                 QVector<QPoint> &positions) {
+  QVector<int> order(sizes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    int sideA = std::max(sizes[a].width(), sizes[a].height());
+    int sideB = std::max(sizes[b].width(), sizes[b].height());
+    if (sideA != sideB) {
+      return sideA > sideB;
+    }
+    return sizes[a].width() * sizes[a].height() >
+           sizes[b].width() * sizes[b].height();
+  });
+
+  positions.resize(sizes.size());
+  QVector<QRect> free{QRect(QPoint(0, 0), bin)};
+  QVector<QRect> split;
+  for (int i : order) {
+    QSize size = sizes[i];
+    int best = -1;
+    int bestShort = INT_MAX;
+    int bestLong = INT_MAX;
+    for (int f = 0; f < free.size(); f++) {
+      int spareWidth = free[f].width() - size.width();
+      int spareHeight = free[f].height() - size.height();
+      if (spareWidth < 0 || spareHeight < 0) {
+        continue;
+      }
+      int shortSide = std::min(spareWidth, spareHeight);
+      int longSide = std::max(spareWidth, spareHeight);
+      if (shortSide < bestShort ||
+          (shortSide == bestShort && longSide < bestLong)) {
+        best = f;
+        bestShort = shortSide;
+        bestLong = longSide;
+      }
+    }
+    if (best < 0) {
+      return false;
+    }
+    QRect used(free[best].topLeft(), size);
+    positions[i] = used.topLeft();
+
+    // Every free rectangle the new one overlaps is replaced by the parts of
+    // it around the new one.
+    split.clear();
+    for (const QRect &f : free) {
+      if (!f.intersects(used)) {
+        split.append(f);
+        continue;
+      }
+      if (used.left() > f.left()) {
+        split.append(
+            QRect(f.left(), f.top(), used.left() - f.left(), f.height()));
+      }
+      if (used.right() < f.right()) {
+        split.append(QRect(used.right() + 1, f.top(),
+                           f.right() - used.right(), f.height()));
+      }
+      if (used.top() > f.top()) {
+        split.append(
+            QRect(f.left(), f.top(), f.width(), used.top() - f.top()));
+      }
+      if (used.bottom() < f.bottom()) {
+        split.append(QRect(f.left(), used.bottom() + 1, f.width(),
+                           f.bottom() - used.bottom()));
+      }
+    }
+
+    // Rectangles inside others add nothing.
+    free.clear();
+    for (int a = 0; a < split.size(); a++) {
+      bool contained = false;
+      for (int b = 0; b < split.size() && !contained; b++) {
+        contained = a != b && split[b].contains(split[a]) &&
+                    (split[a] != split[b] || b < a);
+      }
+      if (!contained) {
+        free.append(split[a]);
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,56 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+///
+/// \brief The AtlasOptions struct controls how frames are put on the sheet
+///
+struct AtlasOptions {
+  bool trim = true;        // cut away fully transparent borders
+  bool deduplicate = true; // identical frames share one area of the sheet
+  int padding = 1;         // transparent pixels between sprites
+};
+
+///
+/// \brief The Atlas class packs frames into one sprite sheet png with a json
+/// description in the common "array" layout game engines read, which keeps
+/// the frames in order: each frame's rectangle on the sheet, where it sits in
+/// its untrimmed frame, and the untrimmed size.
+///
+class Atlas {
+public:
+  struct Sprite {
+    QString name;
+    QImage image;
+  };
+
+  // The same as Export::Progress
+  using Progress = std::function<bool(int done, int total)>;
+
+  static bool save(const QVector<Sprite> &sprites, const QString &fileName,
+                   const AtlasOptions &options = AtlasOptions(),
+                   const Progress &progress = Progress());
+
+private:
+  // One distinct trimmed image and where it is packed.
+  struct Packed {
+    int sprite;    // first sprite with this image
+    QRect trimmed; // its opaque part, in frame coordinates
+    QPoint position;
+  };
+
+  static QRect opaqueBounds(const QImage &image);
+  static bool samePixels(const QImage &a, QRect aRect, const QImage &b,
+                         QRect bRect);
+  static bool pack(const QVector<QSize> &sizes, QSize bin,
+                   QVector<QPoint> &positions);
+};
+
+#endif // ATLAS_H
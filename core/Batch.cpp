@@ -0,0 +1,254 @@
+#include "Batch.h"
+#include "Atlas.h"
+#include "Export.h"
+#include "model.h"
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <cstring>
+
+///
+/// \brief Batch::requested
+/// \return true if the program was started with --batch, checked before any
+/// application object exists
+///
+bool Batch::requested(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--batch") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+///
+/// \brief Batch::run parses the command line and exports every project it
+/// names, for example
+///   Sprite_Editor --batch --gif --sheet --scale 4 --jobs 8 -o out sprites/
+/// \param arguments The application's arguments
+/// \return The exit code: 0 if every project was exported
+///
+int Batch::run(const QStringList &arguments) {
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Exports saved sprite projects without opening the editor.");
+  parser.addHelpOption();
+  QCommandLineOption batchOption("batch", "Run without a window.");
+  QCommandLineOption gifOption("gif",
+                               "Export each project as an animated gif.");
+  QCommandLineOption apngOption(
+      "apng", "Export each project as an animated png, keeping alpha.");
+  QCommandLineOption pngOption("png", "Export every frame as a png.");
+  QCommandLineOption sheetOption(
+      "sheet", "Export each project as a sprite sheet png and json.");
+  QCommandLineOption scaleOption("scale", "Integer upscaling factor.", "n",
+                                 "1");
+  QCommandLineOption fpsOption("fps", "Animation frames per second.", "n",
+                              "1");
+  QCommandLineOption ditherOption(
+      "dither", "Gif dithering: none, ordered or floyd-steinberg.", "mode",
+      "none");
+  QCommandLineOption levelOption(
+      "level", "Png compression level, 0 (fastest) to 9 (smallest).", "n",
+      "-1");
+  QCommandLineOption paletteOption(
+      "palette", "Write pngs with at most 256 colors with a palette.");
+  QCommandLineOption jobsOption(
+      "jobs", "Projects exported at once, the number of cores by default.",
+      "n", QString::number(QThread::idealThreadCount()));
+  QCommandLineOption benchmarkOption(
+      "benchmark", "Time gif quantization of each project instead, with and "
+                   "without the color cache.");
+  QCommandLineOption outputOption(
+      QStringList{"o", "output"},
+      "Directory to write to, next to each project by default.", "dir");
+  parser.addOption(batchOption);
+  parser.addOption(gifOption);
+  parser.addOption(apngOption);
+  parser.addOption(pngOption);
+  parser.addOption(sheetOption);
+  parser.addOption(scaleOption);
+  parser.addOption(fpsOption);
+  parser.addOption(ditherOption);
+  parser.addOption(levelOption);
+  parser.addOption(paletteOption);
+  parser.addOption(jobsOption);
+  parser.addOption(outputOption);
+  parser.addOption(benchmarkOption);
+  parser.addPositionalArgument(
+      "projects", "Project files, or directories searched for .ssp files.",
+      "projects...");
+  parser.process(arguments);
+
+  BatchOptions options;
+  options.gif = parser.isSet(gifOption);
+  options.apng = parser.isSet(apngOption);
+  options.png = parser.isSet(pngOption);
+  options.sheet = parser.isSet(sheetOption);
+  options.scale = parser.value(scaleOption).toInt();
+  options.frameRate = parser.value(fpsOption).toInt();
+  options.level = parser.value(levelOption).toInt();
+  options.palette = parser.isSet(paletteOption);
+  options.outputDir = parser.value(outputOption);
+  int jobs = parser.value(jobsOption).toInt();
+  QString dither = parser.value(ditherOption);
+  if (dither == "ordered") {
+    options.dither = Export::OrderedDither;
+  } else if (dither == "floyd-steinberg") {
+    options.dither = Export::FloydSteinberg;
+  } else if (dither != "none") {
+    qWarning("Unknown --dither mode %s.", qPrintable(dither));
+    return 1;
+  }
+  bool benchmarking = parser.isSet(benchmarkOption);
+  if (!options.gif && !options.apng && !options.png && !options.sheet &&
+      !benchmarking) {
+    qWarning("Nothing to do: pass --gif, --apng, --png and/or --sheet.");
+    return 1;
+  }
+  if (options.scale < 1 || options.scale > Export::maxScale ||
+      options.frameRate < 1 || jobs < 1 || options.level < -1 ||
+      options.level > 9) {
+    qWarning("--scale must be 1 to %d, --level 0 to 9, --fps and --jobs at "
+             "least 1.",
+             Export::maxScale);
+    return 1;
+  }
+  if (!options.outputDir.isEmpty() && !QDir().mkpath(options.outputDir)) {
+    qWarning("Couldn't create %s.", qPrintable(options.outputDir));
+    return 1;
+  }
+
+  QStringList files = projectFiles(parser.positionalArguments());
+  if (files.isEmpty()) {
+    qWarning("No projects given.");
+    return 1;
+  }
+  if (benchmarking) {
+    return benchmark(files, options.dither);
+  }
+
+  // With one worker a gif is encoded on every core instead; with more, the
+  // workers already keep the cores busy.
+  QThreadPool pool;
+  pool.setMaxThreadCount(jobs);
+  bool parallel = jobs == 1;
+  QAtomicInt failed = 0;
+  for (const QString &file : files) {
+    pool.start([file, options, parallel, &failed]() {
+      if (exportProject(file, options, parallel)) {
+        qInfo("Exported %s", qPrintable(file));
+      } else {
+        qWarning("Couldn't export %s", qPrintable(file));
+        failed.fetchAndAddRelaxed(1);
+      }
+    });
+  }
+  pool.waitForDone();
+
+  int exported = files.size() - failed.loadRelaxed();
+  qInfo("%d of %d projects exported.", exported, int(files.size()));
+  return failed.loadRelaxed() == 0 ? 0 : 1;
+}
+
+///
+/// \brief Batch::projectFiles
+/// \param paths Files and directories from the command line
+/// \return The files, with directories replaced by the .ssp files under them
+///
+QStringList Batch::projectFiles(const QStringList &paths) {
+  QStringList files;
+  for (const QString &path : paths) {
+    if (!QFileInfo(path).isDir()) {
+      files.append(path);
+      continue;
+    }
+    QDirIterator it(path, QStringList{"*.ssp"}, QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+      files.append(it.next());
+    }
+  }
+  return files;
+}
+
+///
+/// \brief Batch::benchmark prints how fast each project's frames are mapped
+/// onto gif palettes. Projects are timed one at a time, so they don't compete
+/// for cores.
+/// \param files The projects
+/// \param dither The mapping to time
+/// \return The exit code: 0 if every project could be read
+///
+int Batch::benchmark(const QStringList &files, Export::Dither dither) {
+  int failed = 0;
+  double uncached = 0;
+  double cached = 0;
+  for (const QString &file : files) {
+    QVector<QImage> frames = Model::readComposites(file);
+    if (frames.isEmpty()) {
+      qWarning("Couldn't read %s", qPrintable(file));
+      failed++;
+      continue;
+    }
+    Export::QuantizeSpeed speed = Export::benchmarkQuantize(frames, dither);
+    qInfo("%s: %.1f MP/s uncached, %.1f MP/s cached (%.2fx)", qPrintable(file),
+          speed.uncached, speed.cached, speed.cached / speed.uncached);
+    uncached += speed.uncached;
+    cached += speed.cached;
+  }
+  int timed = files.size() - failed;
+  if (timed > 0) {
+    qInfo("Mean of %d projects: %.1f MP/s uncached, %.1f MP/s cached", timed,
+          uncached / timed, cached / timed);
+  }
+  return failed == 0 ? 0 : 1;
+}
+
+///
+/// \brief Batch::exportProject writes the requested files for one project
+/// \param fileName The project
+/// \param options
+/// \param parallel Let the gif encoder use the global thread pool
+/// \return false if the project couldn't be read or a file written
+///
+bool Batch::exportProject(const QString &fileName, const BatchOptions &options,
+                          bool parallel) {
+  QVector<QImage> frames = Model::readComposites(fileName);
+  if (frames.isEmpty()) {
+    return false;
+  }
+  QFileInfo info(fileName);
+  QString dir = options.outputDir.isEmpty() ? info.path() : options.outputDir;
+  QString base = dir + "/" + info.completeBaseName();
+
+  bool saved = true;
+  if (options.gif) {
+    saved &= Export::saveGIF(frames, options.frameRate, base + ".gif",
+                             options.scale, options.dither, parallel);
+  }
+  if (options.apng) {
+    saved &= Export::saveAPNG(frames, options.frameRate, base + "_anim.png",
+                              options.scale, options.level);
+  }
+  if (options.png) {
+    QStringList fileNames;
+    for (int i = 0; i < frames.size(); i++) {
+      fileNames.append(Export::sequenceName(base, i, frames.size()) + ".png");
+    }
+    saved &= Export::savePNGSequence(frames, fileNames, options.scale,
+                                     options.level, options.palette);
+  }
+  if (options.sheet) {
+    QVector<Atlas::Sprite> sprites;
+    for (int i = 0; i < frames.size(); i++) {
+      sprites.append(Atlas::Sprite{QString("frame_%1").arg(i + 1), frames[i]});
+    }
+    saved &= Atlas::save(sprites, base + "_sheet.png");
+  }
+  return saved;
+}
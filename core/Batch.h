@@ -0,0 +1,41 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "Export.h"
+#include <QString>
+#include <QStringList>
+
+///
+/// \brief The BatchOptions struct is what a batch run was asked to do
+///
+struct BatchOptions {
+  bool gif = false;
+  bool apng = false;    // name_anim.png
+  bool png = false;     // every frame, as name_001.png, name_002.png, ...
+  bool sheet = false;   // name_sheet.png and name_sheet.json
+  int scale = 1;
+  int frameRate = 1;    // projects don't store one, this is the editor default
+  int level = -1;       // png zlib compression level, -1 for zlib's default
+  bool palette = false; // pngs with at most 256 colors use a palette
+  Export::Dither dither = Export::NoDither;
+  QString outputDir;    // next to each project if empty
+};
+
+///
+/// \brief The Batch class converts saved projects from the command line
+/// without creating any widgets, so it runs on a QCoreApplication with no
+/// display. Projects are exported concurrently, one per worker thread.
+///
+class Batch {
+public:
+  static bool requested(int argc, char *argv[]);
+  static int run(const QStringList &arguments);
+
+private:
+  static QStringList projectFiles(const QStringList &paths);
+  static int benchmark(const QStringList &files, Export::Dither dither);
+  static bool exportProject(const QString &fileName,
+                            const BatchOptions &options, bool parallel);
+};
+
+#endif // BATCH_H
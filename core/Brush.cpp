@@ -0,0 +1,158 @@
+#include "Brush.h"
+#include <algorithm>
+
+///
+/// \brief Brush::Brush default constructor, a one pixel square brush
+///
+Brush::Brush() {
+  currentShape = Shape::square;
+  currentSize = 1;
+}
+
+///
+/// \brief Brush::setSize sets the brush diameter in pixels
+/// \param size clamped to [minSize, maxSize]
+///
+void Brush::setSize(int size) {
+  currentSize = std::clamp(size, minSize, maxSize);
+}
+
+///
+/// \brief Brush::setShape sets the brush shape
+/// \param shape
+///
+void Brush::setShape(Shape shape) { currentShape = shape; }
+
+///
+/// \brief Brush::setCustomMask sets the bitmap used by the custom shape. Images
+/// with an alpha channel use their opaque pixels, other images use their dark
+/// pixels.
+/// \param mask
+///
+void Brush::setCustomMask(const QImage &mask) {
+  customMask = mask;
+  // Drop the stamps built from the previous bitmap.
+  for (int size = minSize; size <= maxSize; size++) {
+    stamps.remove(Shape::custom * 256 + size);
+  }
+}
+
+///
+/// \brief Brush::size
+/// \return The brush diameter in pixels
+///
+int Brush::size() const { return currentSize; }
+
+///
+/// \brief Brush::shape
+/// \return The brush shape
+///
+Brush::Shape Brush::shape() const { return currentShape; }
+
+///
+/// \brief Brush::stamp returns the stamp for the current shape and size,
+/// building it the first time that combination is used.
+/// \return The cached stamp
+///
+const BrushStamp &Brush::stamp() {
+  int key = currentShape * 256 + currentSize;
+  if (!stamps.contains(key)) {
+    stamps.insert(key, buildStamp(currentShape, currentSize, customMask));
+  }
+  return stamps[key];
+}
+
+///
+/// \brief Brush::buildStamp rasterizes a brush shape into row spans centered on
+/// the hot spot.
+/// \param shape
+/// \param size The diameter in pixels
+/// \param mask The bitmap for the custom shape
+/// \return The stamp
+///
+BrushStamp Brush::buildStamp(Shape shape, int size, const QImage &mask) {
+  BrushStamp stamp;
+  stamp.size = size;
+  int origin = size / 2;
+
+  // A custom brush without a bitmap falls back to a square.
+  if (shape == Shape::custom && mask.isNull()) {
+    shape = Shape::square;
+  }
+
+  if (shape == Shape::square) {
+    for (int y = 0; y < size; y++) {
+      stamp.spans.append({y - origin, -origin, size});
+    }
+    return stamp;
+  }
+
+  // Build a coverage test for every pixel of the stamp, then collect the runs.
+  QImage scaledMask;
+  bool useAlpha = mask.hasAlphaChannel();
+  if (shape == Shape::custom) {
+    scaledMask = mask.scaled(size, size, Qt::IgnoreAspectRatio,
+                             Qt::FastTransformation)
+                     .convertToFormat(QImage::Format_ARGB32);
+  }
+  float radius = size / 2.0f;
+
+  for (int y = 0; y < size; y++) {
+    int runStart = -1;
+    for (int x = 0; x <= size; x++) {
+      bool covered = false;
+      if (x < size && shape == Shape::round) {
+        float dx = x + 0.5f - radius;
+        float dy = y + 0.5f - radius;
+        covered = dx * dx + dy * dy <= radius * radius;
+      } else if (x < size) {
+        QRgb pixel =
+            reinterpret_cast<const QRgb *>(scaledMask.constScanLine(y))[x];
+        covered = useAlpha ? qAlpha(pixel) >= 128 : qGray(pixel) < 128;
+      }
+
+      if (covered && runStart < 0) {
+        runStart = x;
+      } else if (!covered && runStart >= 0) {
+        stamp.spans.append({y - origin, runStart - origin, x - runStart});
+        runStart = -1;
+      }
+    }
+  }
+  return stamp;
+}
+
+///
+/// \brief Brush::fillSpan overwrites a run of pixels with one color
+/// \param row The first pixel of the run
+/// \param length Number of pixels
+/// \param color Premultiplied color
+///
+void Brush::fillSpan(QRgb *row, int length, QRgb color) {
+  std::fill_n(row, length, color);
+}
+
+///
+/// \brief Brush::eraseSpan applies destination-out to a run of premultiplied
+/// pixels, removing alpha/255 of their coverage.
+/// \param row The first pixel of the run
+/// \param length Number of pixels
+/// \param alpha Eraser strength, 255 clears the pixels
+///
+void Brush::eraseSpan(QRgb *row, int length, int alpha) {
+  if (alpha >= 255) {
+    std::fill_n(row, length, QRgb(0));
+    return;
+  }
+
+  // Scale all four premultiplied channels by (255 - alpha), two at a time.
+  uint keep = 255 - alpha;
+  for (int i = 0; i < length; i++) {
+    uint pixel = row[i];
+    uint redBlue = (pixel & 0xff00ff) * keep;
+    redBlue = (redBlue + ((redBlue >> 8) & 0xff00ff) + 0x800080) >> 8;
+    uint alphaGreen = ((pixel >> 8) & 0xff00ff) * keep;
+    alphaGreen = alphaGreen + ((alphaGreen >> 8) & 0xff00ff) + 0x800080;
+    row[i] = (redBlue & 0xff00ff) | (alphaGreen & 0xff00ff00);
+  }
+}
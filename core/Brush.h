@@ -0,0 +1,52 @@
+#ifndef BRUSH_H
+#define BRUSH_H
+
+#include <QHash>
+#include <QImage>
+#include <QVector>
+
+///
+/// \brief A precomputed brush mask stored as horizontal runs, so stamping is a
+/// handful of row fills instead of a per-pixel mask test.
+///
+struct BrushStamp {
+  struct Span {
+    int y;      // row, relative to the hot spot
+    int x;      // first column, relative to the hot spot
+    int length; // number of covered pixels
+  };
+  int size = 0;
+  QVector<Span> spans;
+};
+
+///
+/// \brief The Brush class holds the current brush settings and caches one stamp
+/// per shape and size.
+///
+class Brush {
+public:
+  enum Shape { square, round, custom };
+  static constexpr int minSize = 1;
+  static constexpr int maxSize = 64;
+
+  Brush();
+  void setSize(int size);
+  void setShape(Shape shape);
+  void setCustomMask(const QImage &mask);
+  int size() const;
+  Shape shape() const;
+  const BrushStamp &stamp();
+
+  static void fillSpan(QRgb *row, int length, QRgb color);
+  static void eraseSpan(QRgb *row, int length, int alpha);
+
+private:
+  static BrushStamp buildStamp(Shape shape, int size, const QImage &mask);
+
+  Shape currentShape;
+  int currentSize;
+  QImage customMask;
+  QHash<int, BrushStamp> stamps; // keyed by shape and size
+};
+
+#endif // BRUSH_H
@@ -0,0 +1,727 @@
+#include "Export.h"
+#include "PngWriter.h"
+#include "gif.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <memory>
+#include <numeric>
+
+static_assert(int(Export::NoDither) == kGifDitherNone &&
+                  int(Export::FloydSteinberg) == kGifDitherFloydSteinberg &&
+                  int(Export::OrderedDither) == kGifDitherOrdered,
+              "Export::Dither is passed to gif.h as is");
+
+///
+/// \brief Export::saveGIF saves frames into an animated gif
+/// \param frames The composite of every frame
+/// \param frameRate Frames per second
+/// \param fileName The file to save to
+/// \param scale Each pixel is written as a scale x scale block. The encoder
+/// does this while compressing, so no scaled frames are allocated. The scaled
+/// frames may be at most maxGIFSide pixels wide and high.
+/// \param dither How frames with more than 255 colors are quantized
+/// \param parallel Encode frames on the global thread pool. The file is byte
+/// for byte the same as a serial export.
+/// \param progress Told about every encoded frame, can cancel the export. The
+/// parallel encoder counts each frame twice, as it is mapped to a palette and
+/// as it is compressed.
+/// \return true if the file was written, false if it couldn't be opened or the
+/// export was cancelled, in which case no file is left behind
+///
+bool Export::saveGIF(const QVector<QImage> &frames, int frameRate,
+                     const QString &fileName, int scale, Dither dither,
+                     bool parallel,
+                     const Progress &progress) {
+  if (frames.isEmpty() || scale < 1 || scale > maxScale) {
+    return false;
+  }
+  int width = frames[0].width();
+  int height = frames[0].height();
+  if (qint64(width) * scale > maxGIFSide ||
+      qint64(height) * scale > maxGIFSide) {
+    return false;
+  }
+
+  // gif.h reads straight (unpremultiplied) RGBA bytes, which is exactly
+  // Format_RGBA8888. Qt's converter unpremultiplies and swizzles the
+  // composite's premultiplied BGRA in one SIMD pass, so each frame goes from
+  // compositor to encoder without leaving memory.
+  QVector<QImage> images;
+  images.reserve(frames.size());
+
+  // Sprites rarely use more than 255 colors, in which case one exact palette
+  // is shared by every frame and nothing is quantized.
+  GifColorMap colors;
+  GifColorMapInit(&colors);
+  bool shared = true;
+  for (const QImage &frame : frames) {
+    images.append(frame.convertToFormat(QImage::Format_RGBA8888));
+    shared = shared && GifColorMapAddImage(&colors, images.last().constBits(),
+                                           width * height);
+  }
+  const GifColorMap *global = shared ? &colors : nullptr;
+
+  int delay = 100 / frameRate; // Converting frames per second into centiseconds
+  int count = images.size();
+  if (!parallel) {
+    GifWriter writer;
+    if (!GifBegin(&writer, qPrintable(fileName), width, height, delay, 8,
+                  dither, global, scale)) {
+      return false;
+    }
+    for (int i = 0; i < count; i++) {
+      GifWriteFrame(&writer, images.at(i).constBits(), width, height, delay, 8,
+                    dither);
+      if (progress && !progress(i + 1, count)) {
+        GifEnd(&writer);
+        QFile::remove(fileName);
+        return false;
+      }
+    }
+    GifEnd(&writer);
+    return true;
+  }
+
+  // The frames are mapped to their palettes and compressed on the pool. Only
+  // the pass that drops the pixels already on screen between the two runs in
+  // order, so an animation of quantized frames spreads as well as a sprite.
+  // Every frame is reported twice, once mapped and once compressed.
+  std::vector<int> indices(count);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::vector<GifMappedFrame> mapped(count); // zeroed, so safe to free
+  QAtomicInt done = 0;
+  QAtomicInt cancelled = 0;
+  auto report = [&] {
+    if (progress && !progress(done.fetchAndAddRelaxed(1) + 1, 2 * count)) {
+      cancelled.storeRelaxed(1);
+    }
+  };
+  QtConcurrent::blockingMap(indices, [&](int i) {
+    if (cancelled.loadRelaxed()) {
+      return;
+    }
+    GifMapFrame(&mapped[i], i == 0 ? nullptr : images.at(i - 1).constBits(),
+                images.at(i).constBits(), width, height, 8, dither, global);
+    report();
+  });
+
+  if (!cancelled.loadRelaxed()) {
+    std::vector<uint8_t> shown(size_t(width) * height * 4);
+    for (int i = 0; i < count; i++) {
+      GifDeltaFrame(&mapped[i], shown.data(), width, height, i == 0);
+    }
+  }
+
+  std::vector<GifBuffer> buffers(count);
+  for (GifBuffer &buffer : buffers) {
+    GifBufferInit(&buffer);
+  }
+  QtConcurrent::blockingMap(indices, [&](int i) {
+    if (!cancelled.loadRelaxed()) {
+      GifWriteMappedFrame(&buffers[i], &mapped[i], width, height, i == 0,
+                          scale);
+      report();
+    }
+    GifFreeMappedFrame(&mapped[i]);
+  });
+
+  // The file is only opened once every frame is encoded, so a cancelled
+  // export never touches it.
+  GifWriter writer;
+  bool saved = !cancelled.loadRelaxed() &&
+               GifBegin(&writer, qPrintable(fileName), width, height, delay, 8,
+                        dither, global, scale);
+  for (GifBuffer &buffer : buffers) {
+    if (saved) {
+      GifWriteEncodedFrame(&writer, &buffer, delay);
+    }
+    GifBufferFree(&buffer);
+  }
+  if (saved) {
+    GifEnd(&writer);
+  }
+  return saved;
+}
+
+///
+/// \brief toPalette maps an image onto the colors it uses
+/// \param image A Format_RGBA8888 image
+/// \param palette Set to the image's colors, as straight RGBA
+/// \param indices Set to one palette index per pixel
+/// \return false if the image has more than 256 colors
+///
+static bool toPalette(const QImage &image, QVector<QRgb> &palette,
+                      QByteArray &indices) {
+  QHash<quint32, int> index;
+  indices.resize(image.width() * image.height());
+  uchar *out = reinterpret_cast<uchar *>(indices.data());
+  quint32 last = 0;
+  int lastIndex = -1;
+  for (int y = 0; y < image.height(); y++) {
+    const quint32 *pixels =
+        reinterpret_cast<const quint32 *>(image.constScanLine(y));
+    for (int x = 0; x < image.width(); x++) {
+      // Sprites are mostly runs of one color, which skip the hash lookup.
+      if (lastIndex < 0 || pixels[x] != last) {
+        last = pixels[x];
+        auto found = index.constFind(last);
+        if (found != index.constEnd()) {
+          lastIndex = found.value();
+        } else if (index.size() == 256) {
+          return false;
+        } else {
+          lastIndex = index.size();
+          index.insert(last, lastIndex);
+          const uchar *rgba = reinterpret_cast<const uchar *>(&pixels[x]);
+          palette.append(qRgba(rgba[0], rgba[1], rgba[2], rgba[3]));
+        }
+      }
+      *out++ = lastIndex;
+    }
+  }
+  return true;
+}
+
+///
+/// \brief Export::savePNG saves one frame to a png
+/// \param frame The composite of the frame
+/// \param fileName The file to save to
+/// \param scale Each pixel is written as a scale x scale block. Rows are
+/// scaled one at a time as they are streamed to the file, so only one scaled
+/// row is ever allocated.
+/// \param level zlib compression level, 0 (fastest) to 9 (smallest), or -1 for
+/// zlib's default
+/// \param palette Write a palette png, a quarter of the pixel data, if the
+/// frame has at most 256 colors. Frames with more are written as RGBA.
+/// \return true if the file was written
+///
+bool Export::savePNG(const QImage &frame, const QString &fileName, int scale,
+                     int level, bool palette) {
+  if (scale < 1 || scale > maxScale || level < -1 || level > 9) {
+    return false;
+  }
+  QSaveFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  QImage image = frame.convertToFormat(QImage::Format_RGBA8888);
+  int width = image.width() * scale;
+  int height = image.height() * scale;
+  PngWriter png(&file, level);
+
+  QVector<QRgb> colors;
+  QByteArray indices;
+  if (palette && toPalette(image, colors, indices)) {
+    if (!png.begin(width, height, colors)) {
+      return false;
+    }
+    QByteArray row(width, 0);
+    for (int y = 0; y < image.height(); y++) {
+      const char *source = indices.constData() + y * image.width();
+      for (int x = 0; x < image.width(); x++) {
+        std::fill_n(row.begin() + x * scale, scale, source[x]);
+      }
+      for (int i = 0; i < scale; i++) {
+        if (!png.writeRow(reinterpret_cast<const uchar *>(row.constData()))) {
+          return false;
+        }
+      }
+    }
+    return png.end() && file.commit();
+  }
+
+  if (!png.begin(width, height)) {
+    return false;
+  }
+  QVector<quint32> row(width);
+  for (int y = 0; y < image.height(); y++) {
+    const quint32 *pixels =
+        reinterpret_cast<const quint32 *>(image.constScanLine(y));
+    for (int x = 0; x < image.width(); x++) {
+      std::fill_n(row.begin() + x * scale, scale, pixels[x]);
+    }
+    for (int i = 0; i < scale; i++) {
+      if (!png.writeRow(reinterpret_cast<const uchar *>(row.constData()))) {
+        return false;
+      }
+    }
+  }
+  return png.end() && file.commit();
+}
+
+///
+/// \brief Export::savePNGSequence saves every frame to its own png. Frames are
+/// compressed on the global thread pool, one file per task, so a long
+/// animation exports about as many times faster as there are cores.
+/// \param frames The images to save
+/// \param fileNames One file per frame
+/// \param scale Integer upscaling factor
+/// \param level zlib compression level, or -1 for the default
+/// \param palette Write frames with at most 256 colors as palette pngs
+/// \param progress Told about every saved frame, can cancel the export
+/// \return true if every file was written. If any couldn't be, or the export
+/// was cancelled, the files already written are removed again.
+///
+bool Export::savePNGSequence(const QVector<QImage> &frames,
+                             const QStringList &fileNames, int scale,
+                             int level, bool palette,
+                             const Progress &progress) {
+  if (frames.isEmpty() || frames.size() != fileNames.size()) {
+    return false;
+  }
+  int count = frames.size();
+  std::vector<int> indices(count);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::vector<char> saved(count, false);
+  QAtomicInt done = 0;
+  QAtomicInt failed = 0;
+  QtConcurrent::blockingMap(indices, [&](int i) {
+    if (failed.loadRelaxed()) {
+      return;
+    }
+    saved[i] = savePNG(frames.at(i), fileNames.at(i), scale, level, palette);
+    if (!saved[i] ||
+        (progress && !progress(done.fetchAndAddRelaxed(1) + 1, count))) {
+      failed.storeRelaxed(1);
+    }
+  });
+
+  if (failed.loadRelaxed()) {
+    for (int i = 0; i < count; i++) {
+      if (saved[i]) {
+        QFile::remove(fileNames.at(i));
+      }
+    }
+    return false;
+  }
+  return true;
+}
+
+///
+/// \brief The FrameChange struct is how a frame differs from the canvas it
+/// is drawn over
+///
+struct FrameChange {
+  QRect rect;       // bounding box of the changed pixels, empty if none
+  bool over = true; // every changed pixel is opaque or over a clear pixel
+};
+
+///
+/// \brief compareFrames finds the pixels an animation frame changes
+/// \param next The frame, as Format_RGBA8888
+/// \param shown The frame before it, as Format_RGBA8888
+/// \param cleared Pixels of shown that were cleared to transparent before
+/// next is drawn
+/// \return The changed pixels and whether next can be blended over them
+///
+static FrameChange compareFrames(const QImage &next, const QImage &shown,
+                                 const QRect &cleared) {
+  FrameChange change;
+  int left = next.width();
+  int right = -1;
+  int top = -1;
+  int bottom = -1;
+  for (int y = 0; y < next.height(); y++) {
+    const quint32 *row =
+        reinterpret_cast<const quint32 *>(next.constScanLine(y));
+    const quint32 *under =
+        reinterpret_cast<const quint32 *>(shown.constScanLine(y));
+    bool clearRow = y >= cleared.top() && y <= cleared.bottom();
+    for (int x = 0; x < next.width(); x++) {
+      quint32 canvas =
+          clearRow && x >= cleared.left() && x <= cleared.right() ? 0
+                                                                  : under[x];
+      if (row[x] == canvas) {
+        continue;
+      }
+      left = qMin(left, x);
+      right = qMax(right, x);
+      if (top < 0) {
+        top = y;
+      }
+      bottom = y;
+      // Drawing over only reproduces a pixel exactly if it is opaque, or if
+      // nothing is under it. Format_RGBA8888 keeps alpha in the last byte.
+      const uchar *rgba = reinterpret_cast<const uchar *>(&row[x]);
+      const uchar *canvasRgba = reinterpret_cast<const uchar *>(&canvas);
+      change.over = change.over && (rgba[3] == 255 || canvasRgba[3] == 0);
+    }
+  }
+  if (top >= 0) {
+    change.rect = QRect(QPoint(left, top), QPoint(right, bottom));
+  }
+  return change;
+}
+
+///
+/// \brief Export::saveAPNG saves frames into an animated png, which keeps
+/// every color and partial transparency, unlike a gif. Each frame after the
+/// first only stores the bounding box of the pixels it changes. If every
+/// changed pixel is opaque or drawn over a clear one, the frame is blended
+/// over the canvas and its unchanged pixels are left transparent, which
+/// compresses like a gif's transparent pixels do. The previous frame's
+/// rectangle is cleared first when that leaves less to draw. Frames that
+/// change nothing lengthen the frame before them instead.
+/// \param frames The composite of every frame
+/// \param frameRate Frames per second
+/// \param fileName The file to save to
+/// \param scale Each pixel is written as a scale x scale block
+/// \param level zlib compression level, or -1 for the default
+/// \param progress Told about every compressed frame, can cancel the export
+/// \return true if the file was written, false if it couldn't be or the
+/// export was cancelled, in which case no file is left behind
+///
+bool Export::saveAPNG(const QVector<QImage> &frames, int frameRate,
+                      const QString &fileName, int scale, int level,
+                      const Progress &progress) {
+  if (frames.isEmpty() || scale < 1 || scale > maxScale || level < -1 ||
+      level > 9) {
+    return false;
+  }
+  QVector<QImage> images = QtConcurrent::blockingMapped<QVector<QImage>>(
+      frames, [](const QImage &frame) {
+        return frame.convertToFormat(QImage::Format_RGBA8888);
+      });
+  int width = images[0].width();
+  int height = images[0].height();
+
+  // Planning is one cheap comparison per frame; it is the compression below
+  // that runs in parallel.
+  QVector<PngWriter::Frame> planned;
+  QVector<QImage> parts; // the pixels each planned frame stores
+  planned.append(PngWriter::Frame());
+  planned[0].rect = images[0].rect();
+  planned[0].delayScale = frameRate;
+  parts.append(images[0]);
+  for (int i = 1; i < images.size(); i++) {
+    PngWriter::Frame &last = planned.last();
+    FrameChange kept = compareFrames(images[i], images[i - 1], QRect());
+    if (kept.rect.isEmpty()) {
+      last.delay++;
+      continue;
+    }
+    FrameChange cleared = compareFrames(images[i], images[i - 1], last.rect);
+    qint64 keptArea = qint64(kept.rect.width()) * kept.rect.height();
+    qint64 clearedArea = cleared.rect.isEmpty()
+                             ? 0
+                             : qint64(cleared.rect.width()) *
+                                   cleared.rect.height();
+    bool clear = clearedArea < keptArea ||
+                 (clearedArea == keptArea && cleared.over && !kept.over);
+    last.dispose =
+        clear ? PngWriter::DisposeBackground : PngWriter::DisposeNone;
+    QRect clearedRect = clear ? last.rect : QRect();
+    FrameChange change = clear ? cleared : kept;
+
+    PngWriter::Frame frame;
+    frame.rect = change.rect;
+    frame.delayScale = frameRate;
+    frame.blend = change.over ? PngWriter::BlendOver : PngWriter::BlendSource;
+    if (frame.rect.isEmpty()) {
+      // Clearing alone shows the frame; a clear pixel still has to be drawn.
+      frame.rect = QRect(0, 0, 1, 1);
+      frame.blend = PngWriter::BlendSource;
+    }
+    QImage part = images[i].copy(frame.rect);
+    if (frame.blend == PngWriter::BlendOver) {
+      for (int y = 0; y < part.height(); y++) {
+        int canvasY = frame.rect.y() + y;
+        quint32 *row = reinterpret_cast<quint32 *>(part.scanLine(y));
+        const quint32 *under = reinterpret_cast<const quint32 *>(
+            images[i - 1].constScanLine(canvasY));
+        for (int x = 0; x < part.width(); x++) {
+          int canvasX = frame.rect.x() + x;
+          quint32 canvas = clearedRect.contains(canvasX, canvasY)
+                               ? 0
+                               : under[canvasX];
+          if (row[x] == canvas) {
+            row[x] = 0;
+          }
+        }
+      }
+    }
+    planned.append(frame);
+    parts.append(part);
+  }
+  for (PngWriter::Frame &frame : planned) {
+    frame.rect = QRect(frame.rect.topLeft() * scale, frame.rect.size() * scale);
+  }
+
+  int count = planned.size();
+  std::vector<int> indices(count);
+  std::iota(indices.begin(), indices.end(), 0);
+  QAtomicInt done = 0;
+  QAtomicInt failed = 0;
+  QtConcurrent::blockingMap(indices, [&](int i) {
+    if (failed.loadRelaxed()) {
+      return;
+    }
+    planned[i].data = PngWriter::compressFrame(parts.at(i), scale, level);
+    if (planned[i].data.isEmpty() ||
+        (progress && !progress(done.fetchAndAddRelaxed(1) + 1, count))) {
+      failed.storeRelaxed(1);
+    }
+  });
+  if (failed.loadRelaxed()) {
+    return false;
+  }
+
+  // The file is only opened once every frame is compressed, so a cancelled
+  // export never touches it.
+  QSaveFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  PngWriter png(&file);
+  if (!png.beginAnimation(width * scale, height * scale, count)) {
+    return false;
+  }
+  for (const PngWriter::Frame &frame : planned) {
+    if (!png.writeFrame(frame)) {
+      return false;
+    }
+  }
+  return png.end() && file.commit();
+}
+
+///
+/// \brief Export::sequenceName numbers one file of a sequence. Numbers are
+/// zero padded to the same width, at least three digits, so the files sort in
+/// order by name everywhere.
+/// \param base The sequence's path without extension
+/// \param index The file's place in the sequence, from 0
+/// \param count How many files the sequence has
+/// \return base_001 for the first file of a short sequence
+///
+QString Export::sequenceName(const QString &base, int index, int count) {
+  int digits = qMax(3, int(QString::number(count).size()));
+  return base + QString("_%1").arg(index + 1, digits, 10, QChar('0'));
+}
+
+///
+/// \brief Export::benchmarkQuantize times how fast the gif encoder maps frames
+/// onto their palettes, the step that runs when a frame has more than 255
+/// colors. Palettes are built beforehand, so only the mapping is timed.
+/// \param frames The composite of every frame
+/// \param dither The mapping to time
+/// \return The speed with and without the color cache
+///
+Export::QuantizeSpeed Export::benchmarkQuantize(const QVector<QImage> &frames,
+                                                Dither dither) {
+  QuantizeSpeed speed{0, 0};
+  if (frames.isEmpty()) {
+    return speed;
+  }
+  int width = frames[0].width();
+  int height = frames[0].height();
+  QVector<QImage> images;
+  std::vector<GifPalette> palettes(frames.size());
+  for (int i = 0; i < frames.size(); i++) {
+    images.append(frames[i].convertToFormat(QImage::Format_RGBA8888));
+    GifMakePalette(nullptr, images[i].constBits(), width, height, 8,
+                   dither != NoDither, &palettes[i]);
+  }
+
+  std::vector<uint8_t> out(width * height * 4);
+  std::unique_ptr<GifColorCache> cache(new GifColorCache);
+  for (bool cached : {false, true}) {
+    // Repeat the animation for at least half a second.
+    QElapsedTimer timer;
+    qint64 pixels = 0;
+    timer.start();
+    do {
+      for (int i = 0; i < images.size(); i++) {
+        GifColorCache *frameCache = nullptr;
+        if (cached) {
+          GifColorCacheInit(cache.get());
+          frameCache = cache.get();
+        }
+        const uint8_t *image = images[i].constBits();
+        if (dither == FloydSteinberg) {
+          GifDitherImage(nullptr, image, out.data(), width, height,
+                         &palettes[i], frameCache);
+        } else if (dither == OrderedDither) {
+          GifOrderedDitherImage(nullptr, image, out.data(), width, height,
+                                &palettes[i], frameCache);
+        } else {
+          GifThresholdImage(nullptr, image, out.data(), width, height,
+                            &palettes[i], frameCache);
+        }
+        pixels += width * height;
+      }
+    } while (timer.elapsed() < 500);
+    double megapixels = pixels / (timer.nsecsElapsed() / 1000.0);
+    (cached ? speed.cached : speed.uncached) = megapixels;
+  }
+  return speed;
+}
+
+///
+/// \brief ExportQueue::ExportQueue creates an empty queue
+/// \param parent
+///
+ExportQueue::ExportQueue(QObject *parent) : QObject{parent} {
+  pool.setMaxThreadCount(1);
+  nextJob = 1;
+}
+
+///
+/// \brief ExportQueue::~ExportQueue cancels every job and waits for the
+/// running one to stop
+///
+ExportQueue::~ExportQueue() {
+  cancelAll();
+  pool.waitForDone();
+}
+
+///
+/// \brief ExportQueue::submitGIF queues an animated gif export
+/// \param frames A snapshot of every frame's composite
+/// \param frameRate Frames per second
+/// \param fileName The file to save to
+/// \param scale Integer upscaling factor
+/// \param dither How frames with more than 255 colors are quantized
+/// \return The job number used by the signals and cancel
+///
+int ExportQueue::submitGIF(const QVector<QImage> &frames, int frameRate,
+                           const QString &fileName, int scale,
+                           Export::Dither dither) {
+  return submit(fileName, [=](const Export::Progress &progress) {
+    return Export::saveGIF(frames, frameRate, fileName, scale, dither, true,
+                           progress);
+  });
+}
+
+///
+/// \brief ExportQueue::submitPNG queues a png export of one frame
+/// \param frame A snapshot of the frame's composite
+/// \param fileName The file to save to
+/// \param scale Integer upscaling factor
+/// \return The job number used by the signals and cancel
+///
+int ExportQueue::submitPNG(const QImage &frame, const QString &fileName,
+                           int scale) {
+  return submit(fileName, [=](const Export::Progress &progress) {
+    if (!progress(0, 1)) {
+      return false;
+    }
+    bool saved = Export::savePNG(frame, fileName, scale);
+    progress(1, 1);
+    return saved;
+  });
+}
+
+///
+/// \brief ExportQueue::submitPNGSequence queues a png export of every frame
+/// \param frames A snapshot of the images to save
+/// \param fileNames One file per frame
+/// \param scale Integer upscaling factor
+/// \param level zlib compression level, or -1 for the default
+/// \param palette Write frames with at most 256 colors as palette pngs
+/// \return The job number used by the signals and cancel
+///
+int ExportQueue::submitPNGSequence(const QVector<QImage> &frames,
+                                   const QStringList &fileNames, int scale,
+                                   int level, bool palette) {
+  return submit(fileNames.value(0), [=](const Export::Progress &progress) {
+    return Export::savePNGSequence(frames, fileNames, scale, level, palette,
+                                   progress);
+  });
+}
+
+///
+/// \brief ExportQueue::submitAPNG queues an animated png export
+/// \param frames A snapshot of every frame's composite
+/// \param frameRate Frames per second
+/// \param fileName The file to save to
+/// \param scale Integer upscaling factor
+/// \return The job number used by the signals and cancel
+///
+int ExportQueue::submitAPNG(const QVector<QImage> &frames, int frameRate,
+                            const QString &fileName, int scale) {
+  return submit(fileName, [=](const Export::Progress &progress) {
+    return Export::saveAPNG(frames, frameRate, fileName, scale, -1, progress);
+  });
+}
+
+///
+/// \brief ExportQueue::submitAtlas queues a sprite sheet export
+/// \param sprites A snapshot of the frames to pack
+/// \param fileName The png to write, the json goes next to it
+/// \return The job number used by the signals and cancel
+///
+int ExportQueue::submitAtlas(const QVector<Atlas::Sprite> &sprites,
+                             const QString &fileName) {
+  return submit(fileName, [=](const Export::Progress &progress) {
+    return Atlas::save(sprites, fileName, AtlasOptions(), progress);
+  });
+}
+
+///
+/// \brief ExportQueue::pendingJobs
+/// \return How many jobs are waiting or running
+///
+int ExportQueue::pendingJobs() {
+  QMutexLocker locker(&mutex);
+  return jobs.size();
+}
+
+///
+/// \brief ExportQueue::cancel stops a job. A waiting job is skipped and a
+/// running one stops at the next frame; either way finished reports it unsaved.
+/// \param job
+///
+void ExportQueue::cancel(int job) {
+  QMutexLocker locker(&mutex);
+  if (jobs.contains(job)) {
+    jobs[job]->storeRelaxed(1);
+  }
+}
+
+///
+/// \brief ExportQueue::cancelAll cancels every waiting and running job
+///
+void ExportQueue::cancelAll() {
+  QMutexLocker locker(&mutex);
+  for (const QSharedPointer<QAtomicInt> &cancelled : jobs) {
+    cancelled->storeRelaxed(1);
+  }
+}
+
+///
+/// \brief ExportQueue::submit queues a job on the pool thread
+/// \param fileName The file the job writes
+/// \param run Does the export, reporting to the progress it is given
+/// \return The job number
+///
+int ExportQueue::submit(
+    const QString &fileName,
+    const std::function<bool(const Export::Progress &)> &run) {
+  QSharedPointer<QAtomicInt> cancelled(new QAtomicInt(0));
+  int job;
+  {
+    QMutexLocker locker(&mutex);
+    job = nextJob++;
+    jobs.insert(job, cancelled);
+  }
+
+  pool.start([this, job, fileName, run, cancelled]() {
+    bool saved = false;
+    if (!cancelled->loadRelaxed()) {
+      saved = run([this, job, cancelled](int done, int total) {
+        emit progress(job, done, total);
+        return !cancelled->loadRelaxed();
+      });
+    }
+    {
+      QMutexLocker locker(&mutex);
+      jobs.remove(job);
+    }
+    emit finished(job, fileName, saved);
+  });
+  return job;
+}
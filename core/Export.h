@@ -0,0 +1,102 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "Atlas.h"
+#include <QAtomicInt>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+
+///
+/// \brief The Export class writes frame composites to image files. It is the
+/// only place gif.h is included.
+///
+class Export {
+public:
+  // Called as frames are encoded, possibly from several threads at once.
+  // Returning false cancels the export.
+  using Progress = std::function<bool(int done, int total)>;
+
+  static constexpr int maxScale = 16;
+  static constexpr int maxGIFSide = 65535; // gif sizes are 16-bit
+
+  // How gif frames with more than 255 colors are reduced to a palette. Only
+  // Floyd-Steinberg carries error between pixels; the others map every pixel
+  // on its own and are much faster on large gradients.
+  enum Dither { NoDither, FloydSteinberg, OrderedDither };
+
+  static bool saveGIF(const QVector<QImage> &frames, int frameRate,
+                      const QString &fileName, int scale = 1,
+                      Dither dither = NoDither, bool parallel = true,
+                      const Progress &progress = Progress());
+  static bool savePNG(const QImage &frame, const QString &fileName,
+                      int scale = 1, int level = -1, bool palette = false);
+  static bool savePNGSequence(const QVector<QImage> &frames,
+                              const QStringList &fileNames, int scale = 1,
+                              int level = -1, bool palette = false,
+                              const Progress &progress = Progress());
+  static bool saveAPNG(const QVector<QImage> &frames, int frameRate,
+                       const QString &fileName, int scale = 1, int level = -1,
+                       const Progress &progress = Progress());
+  static QString sequenceName(const QString &base, int index, int count);
+
+  // Megapixels per second mapped to palettes by the gif encoder
+  struct QuantizeSpeed {
+    double uncached; // every pixel walks the palette's k-d tree
+    double cached;   // repeated colors are looked up in a color cache
+  };
+  static QuantizeSpeed benchmarkQuantize(const QVector<QImage> &frames,
+                                         Dither dither = NoDither);
+};
+
+///
+/// \brief The ExportQueue class runs exports on a background thread so the
+/// editor stays usable while they run. Jobs are given a snapshot of the
+/// composites when they are queued, run one at a time in the order they were
+/// queued, and can be cancelled while waiting or running.
+///
+class ExportQueue : public QObject {
+  Q_OBJECT
+public:
+  explicit ExportQueue(QObject *parent = nullptr);
+  ~ExportQueue();
+
+  int submitGIF(const QVector<QImage> &frames, int frameRate,
+                const QString &fileName, int scale = 1,
+                Export::Dither dither = Export::NoDither);
+  int submitPNG(const QImage &frame, const QString &fileName, int scale = 1);
+  int submitPNGSequence(const QVector<QImage> &frames,
+                        const QStringList &fileNames, int scale = 1,
+                        int level = -1, bool palette = false);
+  int submitAPNG(const QVector<QImage> &frames, int frameRate,
+                 const QString &fileName, int scale = 1);
+  int submitAtlas(const QVector<Atlas::Sprite> &sprites,
+                  const QString &fileName);
+  int pendingJobs();
+
+public slots:
+  void cancel(int job);
+  void cancelAll();
+
+signals:
+  void progress(int job, int done, int total);
+  void finished(int job, const QString &fileName, bool saved);
+
+private:
+  int submit(const QString &fileName,
+             const std::function<bool(const Export::Progress &)> &run);
+
+  QThreadPool pool; // one thread, so exports don't compete with each other
+  QMutex mutex;     // guards jobs, which the pool thread also updates
+  QHash<int, QSharedPointer<QAtomicInt>> jobs; // cancel flag of each job
+  int nextJob;
+};
+
+#endif // EXPORT_H
@@ -0,0 +1,201 @@
+#include "Frame.h"
+#include "Pixel.h"
+#include <QPainter>
+#include <atomic>
+
+///
+/// \brief Layer::newId
+/// \return An id no other layer has had. Frames can be built on several
+/// threads, so ids come from an atomic counter.
+///
+int Layer::newId() {
+  static std::atomic<int> next{1};
+  return next++;
+}
+
+///
+/// \brief Frame::newId
+/// \return An id no other frame has had
+///
+int Frame::newId() {
+  static std::atomic<int> next{1};
+  return next++;
+}
+
+///
+/// \brief Frame Constructor
+/// \param size The size in pixels
+/// \param colorTable The project palette for an indexed frame, or empty
+///
+Frame::Frame(int size, const QVector<QRgb> &colorTable) {
+  id = newId();
+  layers.push_back(std::make_unique<Layer>(size, colorTable));
+  currentLayer = layers[0].get();
+  frameObjectName = "";
+}
+
+///
+/// \brief Frame::Frame copy constructor
+/// \param other
+///
+Frame::Frame(Frame &other) {
+  id = newId();
+  for (unsigned int i = 0; i < other.layers.size(); i++) {
+    std::unique_ptr<Layer> newLayer = std::make_unique<Layer>(1);
+    newLayer->image = other.layers[i]->image;
+    newLayer->visible = other.layers[i]->visible;
+    layers.push_back(std::move(newLayer));
+  }
+  currentLayer = layers[0].get();
+  frameObjectName = "";
+}
+
+///
+/// \brief Frame::~Frame gives the layer images back to the pool
+///
+Frame::~Frame() {
+  for (const std::unique_ptr<Layer> &layer : layers) {
+    ImagePool::release(layer->image);
+  }
+}
+
+///
+/// \brief Composites the layers into a single QImage. Indexed layers are
+/// resolved through their palette.
+/// \return The composited QImage
+///
+QImage Frame::getComposite() {
+  if (layers.empty()) {
+    return QImage();
+  }
+
+  int size = layers[0]->image.size().width();
+  QImage compImage(size, size, QImage::Format_ARGB32_Premultiplied);
+  compImage.fill(QColor{255, 255, 255, 0});
+
+  // The layers of a project are either all indexed or all true color.
+  if (layers[0]->image.format() == QImage::Format_Indexed8) {
+    for (int i = layers.size() - 1; i > -1; i--) {
+      if (layers[i]->visible) {
+        compositeIndexed(compImage, *layers[i]);
+      }
+    }
+    return compImage;
+  }
+
+  QPainter painter;
+
+  painter.begin(&compImage);
+
+  for (int i = layers.size() - 1; i > -1; i--) {
+    if (layers[i]->visible) {
+      painter.drawImage(QPoint(0, 0), layers[i]->image);
+    }
+  }
+
+  painter.end();
+  return compImage;
+}
+
+///
+/// \brief Frame::compositeIndexed draws an indexed layer over a premultiplied
+/// image. The palette is premultiplied once into a lookup table, so each pixel
+/// is a table lookup plus a blend only where the color is translucent.
+/// \param target A 32-bit premultiplied image the size of the layer
+/// \param layer An indexed layer
+///
+void Frame::compositeIndexed(QImage &target, const Layer &layer) {
+  QRgb lookup[256] = {};
+  QVector<QRgb> colorTable = layer.image.colorTable();
+  for (int i = 0; i < colorTable.size() && i < 256; i++) {
+    lookup[i] = qPremultiply(colorTable[i]);
+  }
+
+  for (int y = 0; y < layer.image.height(); y++) {
+    const uchar *source = layer.image.constScanLine(y);
+    QRgb *pixels = reinterpret_cast<QRgb *>(target.scanLine(y));
+    for (int x = 0; x < layer.image.width(); x++) {
+      QRgb color = lookup[source[x]];
+      uint alpha = qAlpha(color);
+      if (alpha == 255) {
+        pixels[x] = color;
+      } else if (alpha != 0) {
+        // Source over: color + pixel * (255 - alpha) / 255, per channel.
+        uint keep = 255 - alpha;
+        uint pixel = pixels[x];
+        uint redBlue = (pixel & 0xff00ff) * keep;
+        redBlue = (redBlue + ((redBlue >> 8) & 0xff00ff) + 0x800080) >> 8;
+        uint alphaGreen = ((pixel >> 8) & 0xff00ff) * keep;
+        alphaGreen = alphaGreen + ((alphaGreen >> 8) & 0xff00ff) + 0x800080;
+        pixels[x] = color + ((redBlue & 0xff00ff) | (alphaGreen & 0xff00ff00));
+      }
+    }
+  }
+}
+
+///
+/// \brief Frame::write writes the frame into JSON Format
+/// \param json
+///
+void Frame::write(QJsonObject &json) {
+  json["name"] = frameObjectName;
+  QImage writeImage = getComposite();
+  QJsonArray imageArray;
+  // for every pixel height wise
+  for (int i = 0; i < writeImage.height(); i++) {
+    QJsonArray rowArray;
+    // for every pixel width wise creates the oixel and writes it to JSON
+    for (int j = 0; j < writeImage.width(); j++) {
+      QColor pixelColor = writeImage.pixelColor(i, j);
+      Pixel pixel;
+      pixel.a = pixelColor.alpha();
+      pixel.r = pixelColor.red();
+      pixel.g = pixelColor.green();
+      pixel.b = pixelColor.blue();
+      QJsonObject pixelObject;
+      pixel.write(pixelObject);
+      rowArray.append(pixelObject);
+    }
+    imageArray.append(rowArray);
+  }
+  json["arrayOfRows"] = imageArray;
+}
+
+///
+/// \brief Frame::read reads the frame from JSON format and turns it back into a
+/// frame
+/// \param json
+///
+void Frame::read(QJsonObject &json) {
+  if (json.contains("name") && json["name"].isString()) {
+    frameObjectName = json["name"].toString();
+  }
+  // builds the array of rows and each row has an array of pixels
+  if (json.contains("arrayOfRows") && json["arrayOfRows"].isArray()) {
+    QJsonArray imgArray = json["arrayOfRows"].toArray();
+    int pixelX = 0;
+    int pixelY = 0;
+
+    for (QJsonValue v : imgArray) {
+      QJsonArray rwArray = v.toArray();
+      // rebuilds the image pixel by pixel
+      for (QJsonValue v : rwArray) {
+        QJsonObject pixelObject = v.toObject();
+        Pixel pixel;
+        pixel.read(pixelObject);
+        QColor color;
+        color.setRed(pixel.r);
+        color.setGreen(pixel.g);
+        color.setBlue(pixel.b);
+        color.setAlpha(pixel.a);
+        currentLayer->image.setPixelColor(pixelX, pixelY, color);
+        pixelX += 1;
+      }
+      pixelX = 0;
+      pixelY += 1;
+    }
+    QTransform rotating;
+    rotating.rotate(90);
+    currentLayer->image = currentLayer->image.transformed(rotating);
+  }
+}
@@ -0,0 +1,97 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "ImagePool.h"
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMatrix2x2>
+#include <QPainter>
+#include <QString>
+#include <QVector>
+#include <algorithm>
+#include <memory>
+#include <vector>
+struct Layer {
+  int id; // stable for the layer's lifetime, unique in the running editor
+  QImage image;
+  QString name;
+  bool visible;
+
+  ///
+  /// \brief Layer creates a transparent layer, reusing a pooled buffer when
+  /// one of the right size is free
+  /// \param size The size in pixels
+  /// \param colorTable The project palette for an indexed layer, which stores
+  /// one palette index per pixel; empty for a true color layer
+  ///
+  Layer(int size, const QVector<QRgb> &colorTable = {}) {
+    id = newId();
+    if (colorTable.isEmpty()) {
+      image = ImagePool::acquire(size, QImage::Format_ARGB32_Premultiplied);
+      image.fill(QColor{255, 255, 255, 0});
+    } else {
+      image = ImagePool::acquire(size, QImage::Format_Indexed8);
+      image.setColorTable(colorTable);
+      image.fill(0);
+    }
+    name = QString("New Layer");
+    visible = true;
+  }
+
+  static int newId();
+};
+
+// The layers of a frame, top first. Each layer is owned by its frame, or by
+// the history entry that holds it while it is removed, and never moves in
+// memory, so reordering layers doesn't invalidate a Layer *.
+using LayerList = std::vector<std::unique_ptr<Layer>>;
+
+class Frame {
+public:
+  // Members
+  int id; // stable for the frame's lifetime, unique in the running editor
+  Layer *currentLayer = NULL;
+  int currentLayerNum = 0;
+  LayerList layers;
+  QString frameObjectName;
+
+  // Methods
+  Frame(int size, const QVector<QRgb> &colorTable = {});
+  Frame();
+  Frame(Frame &other);
+  ~Frame();
+  static int newId();
+  QImage getComposite();
+  void compositeIndexed(QImage &target, const Layer &layer);
+  QImage readImage();
+  // void paintEvent(QPaintEvent* event) override;
+  void read(QJsonObject &json);
+  void write(QJsonObject &json);
+};
+
+// The frames of a project, in order. A frame is owned by the project, or by
+// the history entry that holds it while it is removed, and never moves in
+// memory, so a Frame * stays valid for as long as the frame exists.
+using FrameList = std::vector<std::unique_ptr<Frame>>;
+
+///
+/// \brief moveItem moves a frame or layer to a new index. Only the owning
+/// pointers in between shift, so moving to a neighbouring index is one swap
+/// and no Frame * or Layer * is invalidated.
+/// \param items A FrameList or LayerList
+/// \param from
+/// \param to
+///
+template <typename T>
+void moveItem(std::vector<std::unique_ptr<T>> &items, int from, int to) {
+  if (from < to) {
+    std::rotate(items.begin() + from, items.begin() + from + 1,
+                items.begin() + to + 1);
+  } else if (from > to) {
+    std::rotate(items.begin() + to, items.begin() + from,
+                items.begin() + from + 1);
+  }
+}
+
+#endif // FRAME_H
@@ -0,0 +1,361 @@
+#include "GifReader.h"
+#include <algorithm>
+#include <cstring>
+
+///
+/// \brief GifReader::GifReader creates a reader for a device opened for
+/// reading
+/// \param device
+///
+GifReader::GifReader(QIODevice *device) {
+  input = device;
+  error = false;
+  disposal = 0;
+  transparent = -1;
+  frameDelay = 0;
+  lastDisposal = 0;
+  prefix.resize(4096);
+  suffix.resize(4096);
+  first.resize(4096);
+  length.resize(4096);
+}
+
+///
+/// \brief GifReader::begin reads the header and the global palette
+/// \return false if the device doesn't hold a gif
+///
+bool GifReader::begin() {
+  char header[6];
+  if (input->read(header, 6) != 6 ||
+      (std::memcmp(header, "GIF87a", 6) != 0 &&
+       std::memcmp(header, "GIF89a", 6) != 0)) {
+    error = true;
+    return false;
+  }
+
+  int width, height, flags, background, aspect;
+  if (!readWord(width) || !readWord(height) || !readByte(flags) ||
+      !readByte(background) || !readByte(aspect) || width == 0 ||
+      height == 0 || qint64(width) * height > maxPixels) {
+    error = true;
+    return false;
+  }
+  screen = QSize(width, height);
+  if ((flags & 0x80) && !readPalette(globalColors, 2 << (flags & 7))) {
+    return false;
+  }
+
+  canvas = QImage(screen, QImage::Format_ARGB32);
+  if (canvas.isNull()) {
+    error = true;
+    return false;
+  }
+  canvas.fill(Qt::transparent);
+  return true;
+}
+
+///
+/// \brief GifReader::readFrame decodes the next frame
+/// \param frame Set to the whole canvas as shown after the frame
+/// \return false after the last frame, or if the file is damaged
+///
+bool GifReader::readFrame(QImage &frame) {
+  int block;
+  while (!error && readByte(block)) {
+    if (block == 0x3b) { // trailer
+      return false;
+    }
+    if (block == 0x2c) { // image descriptor
+      if (!readImage()) {
+        return false;
+      }
+      frame = canvas;
+      return true;
+    }
+    if (block != 0x21) {
+      error = true;
+      return false;
+    }
+    int label;
+    if (!readByte(label)) {
+      return false;
+    }
+    if (label == 0xf9) {
+      if (!readGraphicControl()) {
+        return false;
+      }
+    } else if (!skipBlocks()) {
+      return false;
+    }
+  }
+  // A file that ends without a trailer keeps the frames read so far.
+  return false;
+}
+
+///
+/// \brief GifReader::size
+/// \return The size of the canvas
+///
+QSize GifReader::size() const { return screen; }
+
+///
+/// \brief GifReader::delay
+/// \return How long the last frame read is shown, in hundredths of a second
+///
+int GifReader::delay() const { return frameDelay; }
+
+///
+/// \brief GifReader::failed
+/// \return true if the file turned out not to be a gif, or to be damaged
+///
+bool GifReader::failed() const { return error; }
+
+bool GifReader::readByte(int &byte) {
+  char c;
+  if (!input->getChar(&c)) {
+    error = true;
+    return false;
+  }
+  byte = uchar(c);
+  return true;
+}
+
+bool GifReader::readWord(int &word) {
+  int low, high;
+  if (!readByte(low) || !readByte(high)) {
+    return false;
+  }
+  word = low | high << 8;
+  return true;
+}
+
+bool GifReader::readPalette(QVector<QRgb> &colors, int entries) {
+  QByteArray data = input->read(entries * 3);
+  if (data.size() != entries * 3) {
+    error = true;
+    return false;
+  }
+  const uchar *rgb = reinterpret_cast<const uchar *>(data.constData());
+  colors.resize(entries);
+  for (int i = 0; i < entries; i++) {
+    colors[i] = qRgb(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+  }
+  return true;
+}
+
+///
+/// \brief GifReader::skipBlocks skips data sub-blocks up to their terminator
+///
+bool GifReader::skipBlocks() {
+  int size;
+  while (readByte(size) && size > 0) {
+    if (input->skip(size) != size) {
+      error = true;
+      return false;
+    }
+  }
+  return !error;
+}
+
+bool GifReader::readGraphicControl() {
+  int size, flags, delay, index;
+  if (!readByte(size) || size < 4 || !readByte(flags) || !readWord(delay) ||
+      !readByte(index) || input->skip(size - 4) != size - 4 ||
+      !skipBlocks()) {
+    error = true;
+    return false;
+  }
+  disposal = (flags >> 2) & 7;
+  transparent = (flags & 1) ? index : -1;
+  frameDelay = delay;
+  return true;
+}
+
+///
+/// \brief GifReader::readImage decodes one image and draws it on the canvas
+/// \return false if the file is damaged, or the image doesn't fit on the
+/// canvas
+///
+bool GifReader::readImage() {
+  int left, top, width, height, flags;
+  if (!readWord(left) || !readWord(top) || !readWord(width) ||
+      !readWord(height) || !readByte(flags)) {
+    return false;
+  }
+  QVector<QRgb> localColors;
+  if ((flags & 0x80) && !readPalette(localColors, 2 << (flags & 7))) {
+    return false;
+  }
+  const QVector<QRgb> &colors = (flags & 0x80) ? localColors : globalColors;
+
+  // The sizes are untrusted; an image must lie within the canvas, which also
+  // bounds the buffer below by maxPixels.
+  if (left + width > screen.width() || top + height > screen.height()) {
+    error = true;
+    return false;
+  }
+  qint64 pixels = qint64(width) * height;
+  indices.resize(pixels);
+  if (!decode(pixels)) {
+    return false;
+  }
+
+  dispose();
+  QRect rect = QRect(left, top, width, height) & canvas.rect();
+  if (disposal == 3) {
+    restore = canvas.copy();
+  }
+
+  // Interlaced images store rows 0, 8, 16.., then 4, 12.., then 2, 6.., then
+  // the odd rows.
+  bool interlaced = flags & 0x40;
+  int pass = 0;
+  int step = interlaced ? 8 : 1;
+  int y = 0;
+  for (int row = 0; row < height; row++) {
+    int canvasY = top + y;
+    if (canvasY >= rect.top() && canvasY <= rect.bottom()) {
+      const uchar *source = indices.constData() + row * width;
+      QRgb *target = reinterpret_cast<QRgb *>(canvas.scanLine(canvasY));
+      for (int x = rect.left(); x <= rect.right(); x++) {
+        int index = source[x - left];
+        if (index != transparent && index < colors.size()) {
+          target[x] = colors[index];
+        }
+      }
+    }
+    y += step;
+    while (interlaced && y >= height && pass < 3) {
+      pass++;
+      y = 8 >> pass;
+      step = 16 >> pass;
+    }
+  }
+
+  lastDisposal = disposal;
+  lastRect = rect;
+  disposal = 0;
+  transparent = -1;
+  return true;
+}
+
+///
+/// \brief GifReader::decode reads an image's lzw data into indices. Each code
+/// is written straight to its place in the output, back to front along its
+/// prefix chain, so no string is ever copied.
+/// \param pixels How many indices the image has
+/// \return false if the data is damaged
+///
+bool GifReader::decode(int pixels) {
+  int minimumSize;
+  if (!readByte(minimumSize) || minimumSize < 1 || minimumSize > 11) {
+    error = true;
+    return false;
+  }
+  int clear = 1 << minimumSize;
+  int end = clear + 1;
+  for (int code = 0; code < clear; code++) {
+    suffix[code] = code;
+    first[code] = code;
+    length[code] = 1;
+  }
+  int codeSize = minimumSize + 1;
+  int next = clear + 2;
+  int previous = -1;
+
+  uchar *out = indices.data();
+  int written = 0;
+  quint32 bits = 0;
+  int bitCount = 0;
+  char block[255];
+  int blockSize = 0;
+  int blockRead = 0;
+  bool blocksEnded = false;
+  while (true) {
+    while (bitCount < codeSize) {
+      if (blockRead == blockSize) {
+        int size;
+        if (blocksEnded || !readByte(size)) {
+          // Missing end code; keep what was decoded.
+          std::memset(out + written, 0, pixels - written);
+          return !error;
+        }
+        if (size == 0) {
+          blocksEnded = true;
+          continue;
+        }
+        if (input->read(block, size) != size) {
+          error = true;
+          return false;
+        }
+        blockSize = size;
+        blockRead = 0;
+      }
+      bits |= quint32(uchar(block[blockRead++])) << bitCount;
+      bitCount += 8;
+    }
+    int code = bits & ((1 << codeSize) - 1);
+    bits >>= codeSize;
+    bitCount -= codeSize;
+
+    if (code == clear) {
+      codeSize = minimumSize + 1;
+      next = clear + 2;
+      previous = -1;
+      continue;
+    }
+    if (code == end) {
+      break;
+    }
+    if (code > next || (previous < 0 && code >= clear)) {
+      error = true;
+      return false;
+    }
+    if (previous >= 0 && next < 4096) {
+      // A code equal to next is the previous string plus its own first byte.
+      prefix[next] = previous;
+      suffix[next] = first[code == next ? previous : code];
+      first[next] = first[previous];
+      length[next] = length[previous] + 1;
+      next++;
+      if (next == 1 << codeSize && codeSize < 12) {
+        codeSize++;
+      }
+    } else if (code == next) {
+      error = true;
+      return false;
+    }
+    previous = code;
+
+    // Bytes past the end of the image are dropped.
+    int size = length[code];
+    for (int i = size - 1; i >= 0; i--) {
+      if (written + i < pixels) {
+        out[written + i] = suffix[code];
+      }
+      code = prefix[code];
+    }
+    written = std::min(written + size, pixels);
+  }
+  std::memset(out + written, 0, pixels - written);
+
+  // The end code may be followed by more blocks.
+  return blocksEnded || skipBlocks();
+}
+
+///
+/// \brief GifReader::dispose removes the last frame as its disposal method
+/// says before the next one is drawn
+///
+void GifReader::dispose() {
+  if (lastDisposal == 2) {
+    for (int y = lastRect.top(); y <= lastRect.bottom(); y++) {
+      QRgb *row = reinterpret_cast<QRgb *>(canvas.scanLine(y));
+      std::fill(row + lastRect.left(), row + lastRect.right() + 1, 0);
+    }
+  } else if (lastDisposal == 3 && !restore.isNull()) {
+    canvas = restore;
+    restore = QImage();
+  }
+  lastDisposal = 0;
+}
@@ -0,0 +1,64 @@
+#ifndef GIFREADER_H
+#define GIFREADER_H
+
+#include <QIODevice>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+///
+/// \brief The GifReader class decodes an animated gif from a device one frame
+/// at a time. Only the canvas, the canvas a frame may be restored to and one
+/// frame's palette indices are kept, so memory doesn't grow with the length
+/// of the animation. Frames are composed the way browsers show them: partial
+/// frames are drawn over the canvas at their offset, transparent pixels leave
+/// it alone, and each frame's disposal method is applied before the next.
+///
+class GifReader {
+public:
+  explicit GifReader(QIODevice *device);
+  bool begin();
+  bool readFrame(QImage &frame);
+  QSize size() const;
+  int delay() const;
+  bool failed() const;
+
+  // Larger canvases are refused; 64M pixels take 256 MB at 32 bits
+  static constexpr qint64 maxPixels = qint64(1) << 26;
+
+private:
+  bool readByte(int &byte);
+  bool readWord(int &word);
+  bool readPalette(QVector<QRgb> &colors, int entries);
+  bool skipBlocks();
+  bool readGraphicControl();
+  bool readImage();
+  bool decode(int pixels);
+  void dispose();
+
+  QIODevice *input;
+  QSize screen;
+  QVector<QRgb> globalColors;
+  QImage canvas;  // the animation as shown after the last frame
+  QImage restore; // the canvas before the last frame, if it is restored
+  bool error;
+
+  // From the graphic control extension before the next image
+  int disposal;    // 2 clears the frame's rectangle, 3 restores the canvas
+  int transparent; // palette index that isn't drawn, or -1
+  int frameDelay;  // hundredths of a second
+
+  // The last frame, whose disposal runs before the next one is drawn
+  int lastDisposal;
+  QRect lastRect;
+
+  // Lzw string table: every code is its prefix code plus one byte
+  QVector<quint16> prefix;
+  QVector<uchar> suffix;
+  QVector<uchar> first;    // first byte of each code's string
+  QVector<quint16> length; // length of each code's string
+  QVector<uchar> indices;  // the image being decoded, one index per pixel
+};
+
+#endif // GIFREADER_H
@@ -0,0 +1,417 @@
+#include "History.h"
+#include <cstring>
+
+///
+/// \brief History::History default constructor, with a 64 MiB memory limit
+///
+History::History() {
+  memoryLimit = 64 * 1024 * 1024;
+  undoBytes = 0;
+  redoBytes = 0;
+  recording = false;
+  tileColumns = 0;
+}
+
+///
+/// \brief History::beginPixels starts recording a pixel edit of one layer
+/// \param frame Index of the frame being edited
+/// \param layer Index of the layer being edited
+/// \param image The layer image, used for its size
+///
+void History::beginPixels(int frame, int layer, const QImage &image) {
+  pending = HistoryEntry();
+  pending.kind = HistoryEntry::pixels;
+  pending.frame = frame;
+  pending.layer = layer;
+  tileColumns = (image.width() + tileSize - 1) / tileSize;
+  int tileRows = (image.height() + tileSize - 1) / tileSize;
+  capturedTiles.fill(false, tileColumns * tileRows);
+  recording = true;
+}
+
+///
+/// \brief History::capture saves the tiles under a rectangle that is about to
+/// be changed. Tiles already saved by the current edit are skipped, so each
+/// tile is copied at most once per edit.
+/// \param image The layer image, before the change
+/// \param rect The area about to change
+///
+void History::capture(const QImage &image, QRect rect) {
+  if (!recording) {
+    return;
+  }
+  rect &= image.rect();
+  if (rect.isEmpty()) {
+    return;
+  }
+
+  for (int tileY = rect.top() / tileSize; tileY <= rect.bottom() / tileSize;
+       tileY++) {
+    for (int tileX = rect.left() / tileSize;
+         tileX <= rect.right() / tileSize; tileX++) {
+      int tile = tileY * tileColumns + tileX;
+      if (capturedTiles.testBit(tile)) {
+        continue;
+      }
+      capturedTiles.setBit(tile);
+      QRect tileRect =
+          QRect(tileX * tileSize, tileY * tileSize, tileSize, tileSize) &
+          image.rect();
+      pending.tiles.append({tileRect, readRect(image, tileRect), false});
+    }
+  }
+}
+
+///
+/// \brief History::endPixels finishes the pixel edit and records it if it
+/// touched anything
+///
+void History::endPixels() {
+  if (!recording) {
+    return;
+  }
+  recording = false;
+  if (!pending.tiles.isEmpty()) {
+    push(std::move(pending));
+  }
+  pending = HistoryEntry();
+}
+
+///
+/// \brief History::recordAddLayer records a layer inserted into a frame
+/// \param frame Index of the frame
+/// \param layer Index the layer was inserted at
+///
+void History::recordAddLayer(int frame, int layer) {
+  HistoryEntry entry;
+  entry.kind = HistoryEntry::addLayer;
+  entry.frame = frame;
+  entry.layer = layer;
+  push(std::move(entry));
+}
+
+///
+/// \brief History::recordRemoveLayer records a layer removed from a frame
+/// \param frame Index of the frame
+/// \param layer Index the layer was removed from
+/// \param removed The removed layer, owned by the history until the entry is
+/// undone or dropped
+///
+void History::recordRemoveLayer(int frame, int layer,
+                                std::unique_ptr<Layer> removed) {
+  HistoryEntry entry;
+  entry.kind = HistoryEntry::removeLayer;
+  entry.frame = frame;
+  entry.layer = layer;
+  entry.heldLayer = std::move(removed);
+  push(std::move(entry));
+}
+
+///
+/// \brief History::recordMoveLayer records a layer moved within a frame
+/// \param frame Index of the frame
+/// \param from The old index of the layer
+/// \param to The new index of the layer
+///
+void History::recordMoveLayer(int frame, int from, int to) {
+  HistoryEntry entry;
+  entry.kind = HistoryEntry::moveLayer;
+  entry.frame = frame;
+  entry.layer = from;
+  entry.target = to;
+  push(std::move(entry));
+}
+
+///
+/// \brief History::recordAddFrame records a frame inserted into the project
+/// \param frame Index the frame was inserted at
+///
+void History::recordAddFrame(int frame) {
+  HistoryEntry entry;
+  entry.kind = HistoryEntry::addFrame;
+  entry.frame = frame;
+  push(std::move(entry));
+}
+
+///
+/// \brief History::recordRemoveFrame records a frame removed from the project.
+/// The history owns the frame until the entry is undone or dropped.
+/// \param frame Index the frame was removed from
+/// \param removed The removed frame
+///
+void History::recordRemoveFrame(int frame, std::unique_ptr<Frame> removed) {
+  HistoryEntry entry;
+  entry.kind = HistoryEntry::removeFrame;
+  entry.frame = frame;
+  entry.heldFrame = std::move(removed);
+  push(std::move(entry));
+}
+
+///
+/// \brief History::recordMoveFrame records a frame moved within the project
+/// \param from The old index of the frame
+/// \param to The new index of the frame
+///
+void History::recordMoveFrame(int from, int to) {
+  HistoryEntry entry;
+  entry.kind = HistoryEntry::moveFrame;
+  entry.frame = from;
+  entry.target = to;
+  push(std::move(entry));
+}
+
+///
+/// \brief History::canUndo
+/// \return true if there is an edit to undo
+///
+bool History::canUndo() const { return !undoStack.empty(); }
+
+///
+/// \brief History::canRedo
+/// \return true if there is an undone edit to redo
+///
+bool History::canRedo() const { return !redoStack.empty(); }
+
+///
+/// \brief History::undo reverts the most recent edit
+/// \param frames The project frames
+/// \param frame Set to the index of the frame the edit affected
+/// \param layer Set to the index of the layer the edit affected
+/// \return false if there was nothing to undo
+///
+bool History::undo(FrameList &frames, int &frame, int &layer) {
+  if (undoStack.empty()) {
+    return false;
+  }
+  HistoryEntry entry = std::move(undoStack.back());
+  undoStack.pop_back();
+  undoBytes -= entry.size;
+  apply(entry, frames, true);
+  frame = entry.frame;
+  layer = entry.layer;
+  entry.size = entrySize(entry);
+  redoBytes += entry.size;
+  redoStack.push_back(std::move(entry));
+  return true;
+}
+
+///
+/// \brief History::redo re-applies the most recently undone edit
+/// \param frames The project frames
+/// \param frame Set to the index of the frame the edit affected
+/// \param layer Set to the index of the layer the edit affected
+/// \return false if there was nothing to redo
+///
+bool History::redo(FrameList &frames, int &frame, int &layer) {
+  if (redoStack.empty()) {
+    return false;
+  }
+  HistoryEntry entry = std::move(redoStack.back());
+  redoStack.pop_back();
+  redoBytes -= entry.size;
+  apply(entry, frames, false);
+  frame = entry.kind == HistoryEntry::moveFrame ? entry.target : entry.frame;
+  layer = entry.kind == HistoryEntry::moveLayer ? entry.target : entry.layer;
+  entry.size = entrySize(entry);
+  undoBytes += entry.size;
+  undoStack.push_back(std::move(entry));
+  enforceLimit();
+  return true;
+}
+
+///
+/// \brief History::clear drops every entry, e.g. when a new project is started
+///
+void History::clear() {
+  undoStack.clear();
+  redoStack.clear();
+  undoBytes = 0;
+  redoBytes = 0;
+  recording = false;
+  pending = HistoryEntry();
+}
+
+///
+/// \brief History::setMemoryLimit sets how many bytes the entries may hold
+/// before the oldest are dropped. The most recent entry is always kept.
+/// \param bytes
+///
+void History::setMemoryLimit(qsizetype bytes) {
+  memoryLimit = bytes;
+  enforceLimit();
+}
+
+///
+/// \brief History::memoryUsage
+/// \return The number of bytes held by the recorded entries
+///
+qsizetype History::memoryUsage() const {
+  return undoBytes + redoBytes + entrySize(pending);
+}
+
+///
+/// \brief History::push records a new edit, which makes the undone edits
+/// unreachable
+/// \param entry
+///
+void History::push(HistoryEntry entry) {
+  redoStack.clear();
+  redoBytes = 0;
+  entry.size = entrySize(entry);
+  undoBytes += entry.size;
+  undoStack.push_back(std::move(entry));
+  enforceLimit();
+}
+
+///
+/// \brief History::apply undoes or redoes one entry. Pixel tiles are swapped
+/// with the layer contents so the same entry serves both directions.
+/// \param entry
+/// \param frames The project frames
+/// \param undoing true to undo, false to redo
+///
+void History::apply(HistoryEntry &entry, FrameList &frames, bool undoing) {
+  switch (entry.kind) {
+  case HistoryEntry::pixels: {
+    QImage &image = frames[entry.frame]->layers[entry.layer]->image;
+    for (HistoryTile &tile : entry.tiles) {
+      QByteArray stored = tile.compressed ? qUncompress(tile.data) : tile.data;
+      QByteArray current = readRect(image, tile.rect);
+      writeRect(image, tile.rect, stored);
+      tile.data = current;
+      tile.compressed = false;
+    }
+    break;
+  }
+  case HistoryEntry::addLayer:
+  case HistoryEntry::removeLayer: {
+    LayerList &layers = frames[entry.frame]->layers;
+    bool insert = (entry.kind == HistoryEntry::addLayer) != undoing;
+    if (insert) {
+      layers.insert(layers.begin() + entry.layer, std::move(entry.heldLayer));
+    } else {
+      entry.heldLayer = std::move(layers[entry.layer]);
+      layers.erase(layers.begin() + entry.layer);
+    }
+    break;
+  }
+  case HistoryEntry::moveLayer: {
+    int from = undoing ? entry.target : entry.layer;
+    int to = undoing ? entry.layer : entry.target;
+    moveItem(frames[entry.frame]->layers, from, to);
+    break;
+  }
+  case HistoryEntry::addFrame:
+  case HistoryEntry::removeFrame: {
+    bool insert = (entry.kind == HistoryEntry::addFrame) != undoing;
+    if (insert) {
+      frames.insert(frames.begin() + entry.frame, std::move(entry.heldFrame));
+    } else {
+      entry.heldFrame = std::move(frames[entry.frame]);
+      frames.erase(frames.begin() + entry.frame);
+    }
+    break;
+  }
+  case HistoryEntry::moveFrame: {
+    int from = undoing ? entry.target : entry.frame;
+    int to = undoing ? entry.frame : entry.target;
+    moveItem(frames, from, to);
+    break;
+  }
+  }
+}
+
+///
+/// \brief History::enforceLimit compresses the entry that has just left the
+/// most recent ones and drops the oldest entries while the history is over its
+/// memory limit. Every older entry was compressed when it left in turn.
+///
+void History::enforceLimit() {
+  if (undoStack.size() > recentEntries) {
+    compress(undoStack[undoStack.size() - 1 - recentEntries]);
+  }
+
+  while (undoBytes + redoBytes > memoryLimit && undoStack.size() > 1) {
+    undoBytes -= undoStack.front().size;
+    undoStack.pop_front();
+  }
+}
+
+///
+/// \brief History::compress compresses the pixel tiles of an undo entry
+/// \param entry
+///
+void History::compress(HistoryEntry &entry) {
+  bool changed = false;
+  for (HistoryTile &tile : entry.tiles) {
+    if (!tile.compressed) {
+      tile.data = qCompress(tile.data);
+      tile.compressed = true;
+      changed = true;
+    }
+  }
+  if (changed) {
+    undoBytes -= entry.size;
+    entry.size = entrySize(entry);
+    undoBytes += entry.size;
+  }
+}
+
+///
+/// \brief History::entrySize counts the tiles and held images of an entry. A
+/// held image whose pixels are still shared, e.g. a removed copy of a frame,
+/// costs nothing until the other user changes, so it is counted as 0 bytes.
+/// Sizes are taken when an entry is pushed, undone, redone or compressed.
+/// \param entry
+/// \return The number of bytes held by the entry
+///
+qsizetype History::entrySize(const HistoryEntry &entry) {
+  qsizetype total = 0;
+  for (const HistoryTile &tile : entry.tiles) {
+    total += tile.data.size();
+  }
+  if (entry.heldLayer && entry.heldLayer->image.isDetached()) {
+    total += entry.heldLayer->image.sizeInBytes();
+  }
+  if (entry.heldFrame) {
+    for (const std::unique_ptr<Layer> &layer : entry.heldFrame->layers) {
+      if (layer->image.isDetached()) {
+        total += layer->image.sizeInBytes();
+      }
+    }
+  }
+  return total;
+}
+
+///
+/// \brief History::readRect copies the pixels of a rectangle into a buffer
+/// \param image
+/// \param rect Must lie inside the image
+/// \return The pixels, row by row
+///
+QByteArray History::readRect(const QImage &image, QRect rect) {
+  int bytesPerPixel = image.depth() / 8;
+  int rowBytes = rect.width() * bytesPerPixel;
+  QByteArray data(rowBytes * rect.height(), Qt::Uninitialized);
+  for (int y = 0; y < rect.height(); y++) {
+    memcpy(data.data() + y * rowBytes,
+           image.constScanLine(rect.top() + y) + rect.left() * bytesPerPixel,
+           rowBytes);
+  }
+  return data;
+}
+
+///
+/// \brief History::writeRect copies a buffer from readRect back into an image
+/// \param image
+/// \param rect Must lie inside the image
+/// \param data The pixels, row by row
+///
+void History::writeRect(QImage &image, QRect rect, const QByteArray &data) {
+  int bytesPerPixel = image.depth() / 8;
+  int rowBytes = rect.width() * bytesPerPixel;
+  for (int y = 0; y < rect.height(); y++) {
+    memcpy(image.scanLine(rect.top() + y) + rect.left() * bytesPerPixel,
+           data.constData() + y * rowBytes, rowBytes);
+  }
+}
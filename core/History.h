@@ -0,0 +1,106 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "Frame.h"
+#include <QBitArray>
+#include <QByteArray>
+#include <QRect>
+#include <QVector>
+#include <deque>
+#include <memory>
+#include <vector>
+
+///
+/// \brief A rectangle of layer pixels saved by the history. Undoing or redoing
+/// swaps it with the pixels currently in the layer.
+///
+struct HistoryTile {
+  QRect rect;
+  QByteArray data;
+  bool compressed = false;
+};
+
+///
+/// \brief One undoable operation. Pixel edits keep only the tiles they touched,
+/// structural edits keep the layer or frame they took out of the project.
+///
+struct HistoryEntry {
+  enum Kind {
+    pixels,
+    addLayer,
+    removeLayer,
+    moveLayer,
+    addFrame,
+    removeFrame,
+    moveFrame
+  };
+  Kind kind = pixels;
+  int frame = 0;  // index of the frame edited, inserted or removed
+  int layer = 0;  // index of the layer edited, inserted or removed
+  int target = 0; // destination index of a move
+  QVector<HistoryTile> tiles;
+  std::unique_ptr<Layer> heldLayer; // layer currently outside the project
+  std::unique_ptr<Frame> heldFrame; // frame currently outside the project
+  qsizetype size = 0; // bytes counted for the entry in the history's total
+};
+
+///
+/// \brief The History class records edits as deltas and replays them for undo
+/// and redo. Old entries are compressed and the oldest are dropped once the
+/// memory limit is reached. The bytes held are kept as a running total, so
+/// recording an edit costs the same however long the history is.
+///
+class History {
+public:
+  static constexpr int tileSize = 32;
+  static constexpr int recentEntries = 8; // kept uncompressed
+
+  History();
+  History(const History &) = delete;
+  History &operator=(const History &) = delete;
+
+  // Pixel edits
+  void beginPixels(int frame, int layer, const QImage &image);
+  void capture(const QImage &image, QRect rect);
+  void endPixels();
+
+  // Structural edits, recorded after they are made
+  void recordAddLayer(int frame, int layer);
+  void recordRemoveLayer(int frame, int layer, std::unique_ptr<Layer> removed);
+  void recordMoveLayer(int frame, int from, int to);
+  void recordAddFrame(int frame);
+  void recordRemoveFrame(int frame, std::unique_ptr<Frame> removed);
+  void recordMoveFrame(int from, int to);
+
+  bool canUndo() const;
+  bool canRedo() const;
+  bool undo(FrameList &frames, int &frame, int &layer);
+  bool redo(FrameList &frames, int &frame, int &layer);
+  void clear();
+
+  void setMemoryLimit(qsizetype bytes);
+  qsizetype memoryUsage() const;
+
+private:
+  void push(HistoryEntry entry);
+  void apply(HistoryEntry &entry, FrameList &frames, bool undoing);
+  void enforceLimit();
+  void compress(HistoryEntry &entry);
+  static qsizetype entrySize(const HistoryEntry &entry);
+  static QByteArray readRect(const QImage &image, QRect rect);
+  static void writeRect(QImage &image, QRect rect, const QByteArray &data);
+
+  std::deque<HistoryEntry> undoStack;
+  std::vector<HistoryEntry> redoStack;
+  qsizetype undoBytes; // sum of the sizes of the undo entries
+  qsizetype redoBytes; // sum of the sizes of the redo entries
+  qsizetype memoryLimit;
+
+  // The pixel edit being recorded
+  bool recording;
+  HistoryEntry pending;
+  QBitArray capturedTiles;
+  int tileColumns;
+};
+
+#endif // HISTORY_H
@@ -0,0 +1,68 @@
+#include "ImagePool.h"
+#include <QMutexLocker>
+
+QMutex ImagePool::mutex;
+QHash<quint64, QVector<QImage>> ImagePool::images;
+qsizetype ImagePool::bytes = 0;
+
+static quint64 poolKey(int size, QImage::Format format) {
+  return quint64(size) << 32 | quint64(format);
+}
+
+///
+/// \brief ImagePool::acquire gives out a square image, recycled if one of the
+/// same size and format was released. Its pixels are not cleared.
+/// \param size
+/// \param format
+/// \return The image, not shared with any other
+///
+QImage ImagePool::acquire(int size, QImage::Format format) {
+  {
+    QMutexLocker locker(&mutex);
+    auto found = images.find(poolKey(size, format));
+    if (found != images.end() && !found->isEmpty()) {
+      QImage image = found->takeLast();
+      bytes -= image.sizeInBytes();
+      return image;
+    }
+  }
+  return QImage(size, size, format);
+}
+
+///
+/// \brief ImagePool::release takes a layer image back for reuse. Images still
+/// shared with another layer, a copied frame or the history are only let go
+/// of, as are images that would grow the pool past maxBytes.
+/// \param image Left null
+///
+void ImagePool::release(QImage &image) {
+  if (image.isNull() || !image.isDetached() ||
+      image.width() != image.height()) {
+    image = QImage();
+    return;
+  }
+  QMutexLocker locker(&mutex);
+  if (bytes + image.sizeInBytes() <= maxBytes) {
+    bytes += image.sizeInBytes();
+    images[poolKey(image.width(), image.format())].append(image);
+  }
+  image = QImage();
+}
+
+///
+/// \brief ImagePool::clear frees every pooled image
+///
+void ImagePool::clear() {
+  QMutexLocker locker(&mutex);
+  images.clear();
+  bytes = 0;
+}
+
+///
+/// \brief ImagePool::pooledBytes
+/// \return The bytes held by images waiting to be reused
+///
+qsizetype ImagePool::pooledBytes() {
+  QMutexLocker locker(&mutex);
+  return bytes;
+}
@@ -0,0 +1,32 @@
+#ifndef IMAGEPOOL_H
+#define IMAGEPOOL_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+
+///
+/// \brief The ImagePool class recycles the pixel buffers of layers. Frames
+/// give their layer images back when they are destroyed, and new layers of the
+/// same size and format reuse them instead of allocating, so adding and
+/// deleting frames doesn't churn the heap. The pool holds at most maxBytes and
+/// is emptied when a project is replaced, so memory returns to what the
+/// project needs. It is shared by every thread.
+///
+class ImagePool {
+public:
+  static constexpr qsizetype maxBytes = 32 << 20;
+
+  static QImage acquire(int size, QImage::Format format);
+  static void release(QImage &image);
+  static void clear();
+  static qsizetype pooledBytes();
+
+private:
+  static QMutex mutex;
+  static QHash<quint64, QVector<QImage>> images; // by size and format
+  static qsizetype bytes;
+};
+
+#endif // IMAGEPOOL_H
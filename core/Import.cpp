@@ -0,0 +1,190 @@
+#include "Import.h"
+#include <QCollator>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QRect>
+#include <QTransform>
+#include <QtConcurrent>
+#include <algorithm>
+#include <numeric>
+
+///
+/// \brief Import::readGrid cuts a sprite sheet into equally sized tiles, row by
+/// row. Empty tiles at the end of the sheet are dropped.
+/// \param fileName The sheet image
+/// \param tile The size of each tile
+/// \return The tiles, empty if the sheet couldn't be read
+///
+QVector<QImage> Import::readGrid(const QString &fileName, QSize tile) {
+  QImage sheet(fileName);
+  if (sheet.isNull() || tile.isEmpty()) {
+    return QVector<QImage>();
+  }
+  sheet = sheet.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  int columns = sheet.width() / tile.width();
+  int rows = sheet.height() / tile.height();
+
+  std::vector<int> cells(columns * rows);
+  std::iota(cells.begin(), cells.end(), 0);
+  QVector<QImage> tiles = QtConcurrent::blockingMapped<QVector<QImage>>(
+      cells, [&](int cell) {
+        return sheet.copy(cell % columns * tile.width(),
+                          cell / columns * tile.height(), tile.width(),
+                          tile.height());
+      });
+
+  while (!tiles.isEmpty()) {
+    const QImage &last = tiles.last();
+    bool empty = true;
+    for (int y = 0; y < last.height() && empty; y++) {
+      const QRgb *row = reinterpret_cast<const QRgb *>(last.constScanLine(y));
+      empty = std::all_of(row, row + last.width(),
+                          [](QRgb pixel) { return qAlpha(pixel) == 0; });
+    }
+    if (!empty) {
+      break;
+    }
+    tiles.removeLast();
+  }
+  return tiles;
+}
+
+///
+/// \brief Import::readAtlas reads the frames of a sprite sheet described by a
+/// json atlas in the common hash or array layout, as written by Atlas::save.
+/// Trimmed frames are put back in place in their original size, and rotated
+/// ones are turned back.
+/// \param fileName The json file; its meta.image names the sheet, relative to
+/// the json file
+/// \return The frames, in array order or, for the hash layout, in natural
+/// order of their names. Empty if the atlas couldn't be read.
+///
+QVector<QImage> Import::readAtlas(const QString &fileName) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qWarning("Couldn't open atlas file.");
+    return QVector<QImage>();
+  }
+  QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+  QString imageName = json["meta"].toObject()["image"].toString();
+  QImage sheet(QFileInfo(fileName).dir().filePath(imageName));
+  if (sheet.isNull()) {
+    return QVector<QImage>();
+  }
+  sheet = sheet.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  QVector<QJsonObject> frames;
+  if (json["frames"].isArray()) {
+    for (const QJsonValue &frame : json["frames"].toArray()) {
+      frames.append(frame.toObject());
+    }
+  } else {
+    QJsonObject hash = json["frames"].toObject();
+    QStringList names = hash.keys();
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(names.begin(), names.end(), collator);
+    for (const QString &name : names) {
+      frames.append(hash[name].toObject());
+    }
+  }
+
+  return QtConcurrent::blockingMapped<QVector<QImage>>(
+      frames, [&](const QJsonObject &frame) {
+        QJsonObject rect = frame["frame"].toObject();
+        int x = rect["x"].toInt();
+        int y = rect["y"].toInt();
+        int w = rect["w"].toInt();
+        int h = rect["h"].toInt();
+        QImage image;
+        if (frame["rotated"].toBool()) {
+          // Stored turned a quarter clockwise, so w and h are swapped on the
+          // sheet.
+          image = sheet.copy(x, y, h, w).transformed(QTransform().rotate(-90));
+        } else {
+          image = sheet.copy(x, y, w, h);
+        }
+        if (!frame["trimmed"].toBool()) {
+          return image;
+        }
+        QJsonObject source = frame["sourceSize"].toObject();
+        QJsonObject offset = frame["spriteSourceSize"].toObject();
+        QImage untrimmed(source["w"].toInt(), source["h"].toInt(),
+                         QImage::Format_ARGB32_Premultiplied);
+        untrimmed.fill(Qt::transparent);
+        QPainter framePainter(&untrimmed);
+        framePainter.drawImage(offset["x"].toInt(), offset["y"].toInt(), image);
+        return untrimmed;
+      });
+}
+
+///
+/// \brief Import::readSequence reads every png in a directory as a frame
+/// \param directory
+/// \return The images in natural order of their names (walk2 before walk10),
+/// empty if any couldn't be read
+///
+QVector<QImage> Import::readSequence(const QString &directory) {
+  QStringList names =
+      QDir(directory).entryList(QStringList{"*.png", "*.PNG"}, QDir::Files);
+  QCollator collator;
+  collator.setNumericMode(true);
+  std::sort(names.begin(), names.end(), collator);
+
+  QVector<QImage> images = QtConcurrent::blockingMapped<QVector<QImage>>(
+      names, [&](const QString &name) {
+        return QImage(QDir(directory).filePath(name));
+      });
+  for (const QImage &image : images) {
+    if (image.isNull()) {
+      return QVector<QImage>();
+    }
+  }
+  return images;
+}
+
+///
+/// \brief Import::toFrames turns imported images into layer images: square,
+/// premultiplied, with the image in the top left corner. Identical frames are
+/// found by hashing their pixels and then share one QImage, so a sheet that
+/// repeats tiles costs the memory of its distinct tiles only.
+/// \param images
+/// \param size The side of the project's frames
+/// \return One layer image per imported image
+///
+QVector<QImage> Import::toFrames(const QVector<QImage> &images, int size) {
+  QVector<QImage> frames = QtConcurrent::blockingMapped<QVector<QImage>>(
+      images, [size](const QImage &image) {
+        if (image.width() == size && image.height() == size) {
+          return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        }
+        QImage frame(size, size, QImage::Format_ARGB32_Premultiplied);
+        frame.fill(Qt::transparent);
+        QPainter framePainter(&frame);
+        framePainter.drawImage(0, 0, image);
+        return frame;
+      });
+
+  QVector<size_t> hashes = QtConcurrent::blockingMapped<QVector<size_t>>(
+      frames, [](const QImage &frame) {
+        return qHashBits(frame.constBits(), frame.sizeInBytes());
+      });
+  QHash<size_t, QVector<int>> byHash;
+  for (int i = 0; i < frames.size(); i++) {
+    QVector<int> &same = byHash[hashes[i]];
+    auto match = std::find_if(same.begin(), same.end(),
+                              [&](int j) { return frames[j] == frames[i]; });
+    if (match != same.end()) {
+      frames[i] = frames[*match];
+    } else {
+      same.append(i);
+    }
+  }
+  return frames;
+}
@@ -0,0 +1,23 @@
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+///
+/// \brief The Import class reads existing pixel art as frames: sprite sheets
+/// cut on a grid, sheets described by a json atlas, and sequences of pngs.
+/// Files are decoded and sliced on the global thread pool.
+///
+class Import {
+public:
+  static QVector<QImage> readGrid(const QString &fileName, QSize tile);
+  static QVector<QImage> readAtlas(const QString &fileName);
+  static QVector<QImage> readSequence(const QString &directory);
+  static QVector<QImage> toFrames(const QVector<QImage> &images, int size);
+};
+
+#endif // IMPORT_H
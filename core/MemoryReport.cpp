@@ -0,0 +1,144 @@
+#include "MemoryReport.h"
+#include "ImagePool.h"
+#include <QHash>
+
+///
+/// \brief MemoryReport::measure counts the bytes held by every layer image.
+/// Buffers are told apart by QImage::cacheKey, which layers sharing pixel data
+/// have in common, so this only walks the layers, not their pixels.
+/// \param frames The project frames
+/// \param findDuplicates Also hash the pixels of every buffer to find separate
+/// buffers with identical contents, which could have been shared
+/// \return The layer and pool usage; history, selection and display bytes are
+/// left for the caller, which owns them
+///
+MemoryReport MemoryReport::measure(const FrameList &frames,
+                                   bool findDuplicates) {
+  MemoryReport report;
+  QHash<qint64, int> users; // layers using each buffer
+  for (const std::unique_ptr<Frame> &frame : frames) {
+    for (const std::unique_ptr<Layer> &layer : frame->layers) {
+      users[layer->image.cacheKey()]++;
+    }
+  }
+
+  // Buffers with the same pixels, found by hashing each buffer once
+  QHash<qint64, bool> duplicated;
+  if (findDuplicates) {
+    QHash<size_t, QVector<const QImage *>> byHash;
+    QHash<qint64, bool> hashed;
+    for (const std::unique_ptr<Frame> &frame : frames) {
+      for (const std::unique_ptr<Layer> &layer : frame->layers) {
+        const QImage &image = layer->image;
+        if (image.isNull() || hashed.contains(image.cacheKey())) {
+          continue;
+        }
+        hashed.insert(image.cacheKey(), true);
+        QVector<const QImage *> &same =
+            byHash[qHashBits(image.constBits(), image.sizeInBytes())];
+        for (const QImage *other : same) {
+          if (*other == image) {
+            duplicated.insert(other->cacheKey(), true);
+            duplicated.insert(image.cacheKey(), true);
+            report.duplicateBytes += image.sizeInBytes();
+            break;
+          }
+        }
+        same.append(&image);
+      }
+    }
+  }
+
+  QHash<qint64, bool> counted;
+  for (const std::unique_ptr<Frame> &frame : frames) {
+    QVector<LayerUsage> layers;
+    for (const std::unique_ptr<Layer> &layer : frame->layers) {
+      LayerUsage usage;
+      qint64 key = layer->image.cacheKey();
+      usage.name = layer->name;
+      usage.bytes = layer->image.sizeInBytes();
+      usage.shared = users.value(key) > 1;
+      usage.duplicate = duplicated.contains(key);
+      if (!counted.contains(key)) {
+        counted.insert(key, true);
+        (usage.shared ? report.sharedBytes : report.uniqueBytes) +=
+            usage.bytes;
+      }
+      layers.append(usage);
+    }
+    report.frames.append(layers);
+  }
+  report.poolBytes = ImagePool::pooledBytes();
+  return report;
+}
+
+///
+/// \brief MemoryReport::layerBytes
+/// \return The bytes of every distinct layer buffer
+///
+qsizetype MemoryReport::layerBytes() const { return uniqueBytes + sharedBytes; }
+
+///
+/// \brief MemoryReport::total
+/// \return Every byte the report accounts for
+///
+qsizetype MemoryReport::total() const {
+  return layerBytes() + historyBytes + poolBytes + selectionBytes +
+         displayBytes;
+}
+
+///
+/// \brief MemoryReport::summary
+/// \return One line per category, e.g. for a tooltip
+///
+QString MemoryReport::summary() const {
+  QString text =
+      QString("Layers: %1 (%2 shared)\nUndo history: %3\nBuffer pool: %4\n"
+              "Selection: %5\nDisplay: %6\nTotal: %7")
+          .arg(formatBytes(layerBytes()), formatBytes(sharedBytes),
+               formatBytes(historyBytes), formatBytes(poolBytes),
+               formatBytes(selectionBytes), formatBytes(displayBytes),
+               formatBytes(total()));
+  if (duplicateBytes > 0) {
+    text += QString("\nIdentical but unshared: %1")
+                .arg(formatBytes(duplicateBytes));
+  }
+  return text;
+}
+
+///
+/// \brief MemoryReport::details
+/// \return The summary followed by every frame and layer
+///
+QString MemoryReport::details() const {
+  QString text = summary() + "\n";
+  for (int i = 0; i < frames.size(); i++) {
+    qsizetype frameBytes = 0;
+    for (const LayerUsage &layer : frames[i]) {
+      frameBytes += layer.bytes;
+    }
+    text += QString("\nFrame %1: %2\n").arg(i + 1).arg(formatBytes(frameBytes));
+    for (const LayerUsage &layer : frames[i]) {
+      text += QString("  %1: %2%3%4\n")
+                  .arg(layer.name, formatBytes(layer.bytes),
+                       QString(layer.shared ? ", shared" : ""),
+                       QString(layer.duplicate ? ", duplicate" : ""));
+    }
+  }
+  return text;
+}
+
+///
+/// \brief MemoryReport::formatBytes
+/// \param bytes
+/// \return The size in B, KB or MB
+///
+QString MemoryReport::formatBytes(qsizetype bytes) {
+  if (bytes < 1024) {
+    return QString("%1 B").arg(bytes);
+  }
+  if (bytes < 1024 * 1024) {
+    return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+  }
+  return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
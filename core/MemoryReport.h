@@ -0,0 +1,39 @@
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include "Frame.h"
+#include <QString>
+#include <QVector>
+
+///
+/// \brief The MemoryReport struct is how many bytes an open project holds, and
+/// where. Layer images that share pixel data (copied frames, repeated imported
+/// tiles) are counted once, so the totals are what is actually resident.
+///
+struct MemoryReport {
+  struct LayerUsage {
+    QString name;
+    qsizetype bytes = 0;
+    bool shared = false;    // the buffer is also used by another layer
+    bool duplicate = false; // another buffer holds the same pixels
+  };
+
+  QVector<QVector<LayerUsage>> frames; // per frame, per layer
+
+  qsizetype uniqueBytes = 0;    // buffers used by one layer
+  qsizetype sharedBytes = 0;    // buffers used by several layers, once each
+  qsizetype duplicateBytes = 0; // buffers that could be shared, if searched
+  qsizetype historyBytes = 0;   // undo and redo entries
+  qsizetype poolBytes = 0;      // layer buffers waiting to be reused
+  qsizetype selectionBytes = 0; // lifted selection pixels
+  qsizetype displayBytes = 0;   // editor, preview and thumbnail pixmaps
+
+  static MemoryReport measure(const FrameList &frames, bool findDuplicates);
+  qsizetype layerBytes() const;
+  qsizetype total() const;
+  QString summary() const;
+  QString details() const;
+  static QString formatBytes(qsizetype bytes);
+};
+
+#endif // MEMORYREPORT_H
@@ -0,0 +1,151 @@
+#include "Palette.h"
+#include "Pixel.h"
+#include <QJsonObject>
+#include <limits>
+
+///
+/// \brief Palette::Palette creates a palette holding only the transparent color
+///
+Palette::Palette() { clear(); }
+
+int Palette::size() const { return colors.size(); }
+
+bool Palette::isFull() const { return colors.size() >= maxColors; }
+
+///
+/// \brief Palette::color
+/// \param index
+/// \return The color at the index, or transparent if there is none
+///
+QRgb Palette::color(int index) const {
+  if (index < 0 || index >= colors.size()) {
+    return qRgba(0, 0, 0, 0);
+  }
+  return colors[index];
+}
+
+///
+/// \brief Palette::setColor changes one palette entry. Every pixel using the
+/// index changes with it. The transparent entry can't be changed.
+/// \param index
+/// \param color
+///
+void Palette::setColor(int index, QRgb color) {
+  if (index <= transparent || index >= colors.size()) {
+    return;
+  }
+  colors[index] = color;
+  indices.clear();
+  for (int i = colors.size() - 1; i >= 0; i--) {
+    indices.insert(colors[i], i);
+  }
+}
+
+///
+/// \brief Palette::indexOf
+/// \param color
+/// \return The index of the color, or -1 if it is not in the palette. Every
+/// fully transparent color is at index 0.
+///
+int Palette::indexOf(QRgb color) const {
+  if (qAlpha(color) == 0) {
+    return transparent;
+  }
+  return indices.value(color, -1);
+}
+
+///
+/// \brief Palette::add finds a color, appending it if it is new
+/// \param color
+/// \return Its index, or the index of the nearest color if the palette is full
+///
+int Palette::add(QRgb color) {
+  int index = indexOf(color);
+  if (index >= 0) {
+    return index;
+  }
+  if (isFull()) {
+    return nearest(color);
+  }
+  colors.append(color);
+  indices.insert(color, colors.size() - 1);
+  return colors.size() - 1;
+}
+
+///
+/// \brief Palette::nearest
+/// \param color
+/// \return The index of the opaque entry closest to the color, or 0 if the
+/// color is transparent or there are no other entries
+///
+int Palette::nearest(QRgb color) const {
+  if (qAlpha(color) == 0) {
+    return transparent;
+  }
+  int best = transparent;
+  int bestDistance = std::numeric_limits<int>::max();
+  for (int i = 1; i < colors.size(); i++) {
+    int red = qRed(colors[i]) - qRed(color);
+    int green = qGreen(colors[i]) - qGreen(color);
+    int blue = qBlue(colors[i]) - qBlue(color);
+    int alpha = qAlpha(colors[i]) - qAlpha(color);
+    int distance = red * red + green * green + blue * blue + alpha * alpha;
+    if (distance < bestDistance) {
+      best = i;
+      bestDistance = distance;
+    }
+  }
+  return best;
+}
+
+///
+/// \brief Palette::colorTable
+/// \return The colors in index order, for QImage::setColorTable
+///
+const QVector<QRgb> &Palette::colorTable() const { return colors; }
+
+///
+/// \brief Palette::clear removes every color but the transparent one
+///
+void Palette::clear() {
+  colors = {qRgba(0, 0, 0, 0)};
+  indices.clear();
+  indices.insert(colors[0], transparent);
+}
+
+///
+/// \brief Palette::read reads the palette from JSON
+/// \param json An array of pixels, in index order
+///
+void Palette::read(const QJsonArray &json) {
+  clear();
+  for (int i = 1; i < json.size() && !isFull(); i++) {
+    QJsonObject pixelObject = json[i].toObject();
+    Pixel pixel;
+    pixel.read(pixelObject);
+    QRgb color = qRgba(pixel.r, pixel.g, pixel.b, pixel.a);
+    colors.append(color);
+    if (!indices.contains(color)) {
+      indices.insert(color, colors.size() - 1);
+    }
+  }
+}
+
+///
+/// \brief Palette::write writes the palette to JSON
+/// \return An array of pixels, in index order
+///
+QJsonArray Palette::write() const {
+  QJsonArray json;
+  for (QRgb color : colors) {
+    Pixel pixel;
+    pixel.r = qRed(color);
+    pixel.g = qGreen(color);
+    pixel.b = qBlue(color);
+    pixel.a = qAlpha(color);
+    QJsonObject pixelObject;
+    pixel.write(pixelObject);
+    json.append(pixelObject);
+  }
+  return json;
+}
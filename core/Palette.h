@@ -0,0 +1,37 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <QHash>
+#include <QJsonArray>
+#include <QVector>
+
+///
+/// \brief The Palette class is the shared color table of an indexed project.
+/// Layers store an index into it per pixel; index 0 is always transparent.
+/// Colors are unpremultiplied ARGB, the same as QImage color tables.
+///
+class Palette {
+public:
+  static constexpr int maxColors = 256;
+  static constexpr int transparent = 0;
+
+  Palette();
+  int size() const;
+  bool isFull() const;
+  QRgb color(int index) const;
+  void setColor(int index, QRgb color);
+  int indexOf(QRgb color) const;
+  int add(QRgb color);
+  int nearest(QRgb color) const;
+  const QVector<QRgb> &colorTable() const;
+  void clear();
+
+  void read(const QJsonArray &json);
+  QJsonArray write() const;
+
+private:
+  QVector<QRgb> colors;
+  QHash<QRgb, int> indices; // color to its first index
+};
+
+#endif // PALETTE_H
@@ -0,0 +1,360 @@
+#include "PngWriter.h"
+#include <QtEndian>
+#include <cstring>
+
+///
+/// \brief PngWriter::PngWriter creates a writer for a device opened for writing
+/// \param device
+/// \param level zlib compression level, 0 (none) to 9 (smallest)
+///
+PngWriter::PngWriter(QIODevice *device, int level) {
+  output = device;
+  this->level = level;
+  started = false;
+  rowSize = 0;
+  compressedSize = 0;
+  sequence = -1;
+}
+
+PngWriter::~PngWriter() {
+  if (started) {
+    deflateEnd(&stream);
+  }
+}
+
+///
+/// \brief PngWriter::begin writes the header of an RGBA png, whose rows are
+/// width straight RGBA pixels
+/// \param width
+/// \param height
+/// \return false if the device couldn't be written
+///
+bool PngWriter::begin(int width, int height) {
+  return start(width, height, 6, 4, QVector<QRgb>());
+}
+
+///
+/// \brief PngWriter::begin writes the header of a palette png, whose rows are
+/// width palette indices
+/// \param width
+/// \param height
+/// \param palette Up to 256 straight (not premultiplied) colors
+/// \return false if the device couldn't be written
+///
+bool PngWriter::begin(int width, int height, const QVector<QRgb> &palette) {
+  if (palette.isEmpty() || palette.size() > 256) {
+    return false;
+  }
+  return start(width, height, 3, 1, palette);
+}
+
+///
+/// \brief PngWriter::writeHeader writes the png signature and header
+/// \param width
+/// \param height
+/// \param colorType 6 for RGBA, 3 for a palette
+/// \param palette The palette for color type 3
+/// \return false if the device couldn't be written
+///
+bool PngWriter::writeHeader(int width, int height, int colorType,
+                            const QVector<QRgb> &palette) {
+  if (output->write("\x89PNG\r\n\x1a\n", 8) != 8) {
+    return false;
+  }
+
+  char header[13];
+  qToBigEndian<quint32>(width, header);
+  qToBigEndian<quint32>(height, header + 4);
+  header[8] = 8; // bits per channel or index
+  header[9] = colorType;
+  header[10] = 0; // deflate
+  header[11] = 0; // adaptive filtering
+  header[12] = 0; // not interlaced
+  if (!writeChunk("IHDR", header, sizeof(header))) {
+    return false;
+  }
+
+  if (palette.isEmpty()) {
+    return true;
+  }
+  QByteArray colors;
+  QByteArray alphas;
+  for (QRgb color : palette) {
+    colors.append(char(qRed(color)));
+    colors.append(char(qGreen(color)));
+    colors.append(char(qBlue(color)));
+    alphas.append(char(qAlpha(color)));
+  }
+  // Entries past the last translucent one default to opaque.
+  while (!alphas.isEmpty() && uchar(alphas.back()) == 255) {
+    alphas.chop(1);
+  }
+  return writeChunk("PLTE", colors.constData(), colors.size()) &&
+         (alphas.isEmpty() ||
+          writeChunk("tRNS", alphas.constData(), alphas.size()));
+}
+
+///
+/// \brief PngWriter::start writes the png header and starts compressing
+/// \param width
+/// \param height
+/// \param colorType 6 for RGBA, 3 for a palette
+/// \param bytesPerPixel
+/// \param palette The palette for color type 3
+/// \return false if the device couldn't be written
+///
+bool PngWriter::start(int width, int height, int colorType,
+                      int bytesPerPixel, const QVector<QRgb> &palette) {
+  if (started || sequence >= 0 ||
+      !writeHeader(width, height, colorType, palette)) {
+    return false;
+  }
+
+  std::memset(&stream, 0, sizeof(stream));
+  if (deflateInit(&stream, level) != Z_OK) {
+    return false;
+  }
+  started = true;
+  rowSize = width * bytesPerPixel;
+  previous.clear();
+  filtered.resize(rowSize + 1);
+  compressed.resize(chunkSize);
+  compressedSize = 0;
+  return true;
+}
+
+///
+/// \brief PngWriter::writeRow compresses the next row
+/// \param row width straight RGBA pixels, or width palette indices
+/// \return false if the device couldn't be written
+///
+bool PngWriter::writeRow(const uchar *row) {
+  if (!started) {
+    return false;
+  }
+  filterRow(row, rowSize, previous, filtered);
+  return compress(reinterpret_cast<const uchar *>(filtered.constData()),
+                  filtered.size(), Z_NO_FLUSH);
+}
+
+///
+/// \brief PngWriter::end finishes the compressed data and writes the trailer
+/// \return false if the device couldn't be written
+///
+bool PngWriter::end() {
+  if (sequence >= 0) {
+    sequence = -1;
+    return writeChunk("IEND", nullptr, 0);
+  }
+  if (!started) {
+    return false;
+  }
+  bool written = compress(nullptr, 0, Z_FINISH) &&
+                 (compressedSize == 0 ||
+                  writeChunk("IDAT", compressed.constData(), compressedSize)) &&
+                 writeChunk("IEND", nullptr, 0);
+  deflateEnd(&stream);
+  started = false;
+  return written;
+}
+
+///
+/// \brief PngWriter::beginAnimation writes the header of an RGBA animated png.
+/// The first frame must cover the whole image; it is also what viewers that
+/// don't know APNG show.
+/// \param width
+/// \param height
+/// \param frames How many frames will be written
+/// \return false if the device couldn't be written
+///
+bool PngWriter::beginAnimation(int width, int height, int frames) {
+  if (started || sequence >= 0 || !writeHeader(width, height, 6, {})) {
+    return false;
+  }
+  char control[8];
+  qToBigEndian<quint32>(frames, control);
+  qToBigEndian<quint32>(0, control + 4); // loop forever
+  sequence = 0;
+  return writeChunk("acTL", control, sizeof(control));
+}
+
+///
+/// \brief PngWriter::writeFrame writes the next animation frame
+/// \param frame
+/// \return false if the device couldn't be written
+///
+bool PngWriter::writeFrame(const Frame &frame) {
+  if (sequence < 0) {
+    return false;
+  }
+  // The first frame is the default image, stored in IDAT chunks. The others
+  // go in fdAT chunks, which are IDAT data after a sequence number.
+  bool first = sequence == 0;
+  char control[26];
+  qToBigEndian<quint32>(sequence++, control);
+  qToBigEndian<quint32>(frame.rect.width(), control + 4);
+  qToBigEndian<quint32>(frame.rect.height(), control + 8);
+  qToBigEndian<quint32>(frame.rect.x(), control + 12);
+  qToBigEndian<quint32>(frame.rect.y(), control + 16);
+  qToBigEndian<quint16>(frame.delay, control + 20);
+  qToBigEndian<quint16>(frame.delayScale, control + 22);
+  control[24] = frame.dispose == DisposeBackground ? 1 : 0;
+  control[25] = frame.blend == BlendOver ? 1 : 0;
+  if (!writeChunk("fcTL", control, sizeof(control))) {
+    return false;
+  }
+
+  QByteArray chunk;
+  for (int offset = 0; offset < frame.data.size(); offset += chunkSize) {
+    int size = qMin(chunkSize, int(frame.data.size()) - offset);
+    if (first) {
+      if (!writeChunk("IDAT", frame.data.constData() + offset, size)) {
+        return false;
+      }
+      continue;
+    }
+    chunk.resize(4 + size);
+    qToBigEndian<quint32>(sequence++, chunk.data());
+    std::memcpy(chunk.data() + 4, frame.data.constData() + offset, size);
+    if (!writeChunk("fdAT", chunk.constData(), chunk.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+///
+/// \brief PngWriter::compressFrame filters and compresses an animation frame
+/// the same way rows are written to a still png
+/// \param image A Format_RGBA8888 image
+/// \param scale Each pixel is written as a scale x scale block
+/// \param level zlib compression level
+/// \return The zlib stream, empty if it couldn't be compressed
+///
+QByteArray PngWriter::compressFrame(const QImage &image, int scale,
+                                    int level) {
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  if (deflateInit(&stream, level) != Z_OK) {
+    return QByteArray();
+  }
+  int rowSize = image.width() * scale * 4;
+  int rows = image.height() * scale;
+  QVector<quint32> row(image.width() * scale);
+  QByteArray previous;
+  QByteArray filtered(rowSize + 1, 0);
+  QByteArray data;
+  int dataSize = 0;
+  // One pass per row, and a last one with no input that finishes the stream.
+  for (int y = 0; y <= rows; y++) {
+    bool last = y == rows;
+    if (!last) {
+      if (y % scale == 0) {
+        const quint32 *pixels =
+            reinterpret_cast<const quint32 *>(image.constScanLine(y / scale));
+        for (int x = 0; x < image.width(); x++) {
+          std::fill_n(row.begin() + x * scale, scale, pixels[x]);
+        }
+      }
+      filterRow(reinterpret_cast<const uchar *>(row.constData()), rowSize,
+                previous, filtered);
+    }
+    stream.next_in = reinterpret_cast<Bytef *>(filtered.data());
+    stream.avail_in = last ? 0 : filtered.size();
+    int result;
+    do {
+      if (data.size() - dataSize < chunkSize) {
+        data.resize(dataSize + chunkSize);
+      }
+      stream.next_out = reinterpret_cast<Bytef *>(data.data()) + dataSize;
+      stream.avail_out = data.size() - dataSize;
+      result = deflate(&stream, last ? Z_FINISH : Z_NO_FLUSH);
+      dataSize = data.size() - stream.avail_out;
+    } while (result != Z_STREAM_ERROR &&
+             (stream.avail_out == 0 || (last && result != Z_STREAM_END)));
+    if (result == Z_STREAM_ERROR) {
+      deflateEnd(&stream);
+      return QByteArray();
+    }
+  }
+  deflateEnd(&stream);
+  data.resize(dataSize);
+  return data;
+}
+
+///
+/// \brief PngWriter::filterRow picks a row's filter. A row equal to the last
+/// one is written with Up, which makes it all zeros.
+/// \param row The unfiltered row
+/// \param rowSize
+/// \param previous The last row that wasn't a repeat
+/// \param filtered Set to the filter byte followed by the filtered row
+///
+void PngWriter::filterRow(const uchar *row, int rowSize, QByteArray &previous,
+                          QByteArray &filtered) {
+  if (previous.size() == rowSize &&
+      std::memcmp(previous.constData(), row, rowSize) == 0) {
+    filtered[0] = 2; // Up: every byte is the same as the byte above
+    std::memset(filtered.data() + 1, 0, rowSize);
+  } else {
+    filtered[0] = 0; // None
+    std::memcpy(filtered.data() + 1, row, rowSize);
+    previous.resize(rowSize);
+    std::memcpy(previous.data(), row, rowSize);
+  }
+}
+
+///
+/// \brief PngWriter::compress feeds data to deflate, writing an IDAT chunk
+/// whenever the output fills one
+/// \param data
+/// \param size
+/// \param flush Z_NO_FLUSH, or Z_FINISH to end the stream
+/// \return false if the device couldn't be written
+///
+bool PngWriter::compress(const uchar *data, int size, int flush) {
+  stream.next_in = const_cast<Bytef *>(data);
+  stream.avail_in = size;
+  while (true) {
+    stream.next_out =
+        reinterpret_cast<Bytef *>(compressed.data()) + compressedSize;
+    stream.avail_out = chunkSize - compressedSize;
+    int result = deflate(&stream, flush);
+    if (result == Z_STREAM_ERROR) {
+      return false;
+    }
+    compressedSize = chunkSize - stream.avail_out;
+    if (compressedSize == chunkSize) {
+      if (!writeChunk("IDAT", compressed.constData(), compressedSize)) {
+        return false;
+      }
+      compressedSize = 0;
+      continue;
+    }
+    // There was room left, so deflate has consumed everything it was given.
+    if (flush != Z_FINISH || result == Z_STREAM_END) {
+      return true;
+    }
+  }
+}
+
+///
+/// \brief PngWriter::writeChunk writes one png chunk with its length and crc
+/// \param type Four letter chunk type
+/// \param data
+/// \param size
+/// \return false if the device couldn't be written
+///
+bool PngWriter::writeChunk(const char *type, const char *data, int size) {
+  char length[4];
+  qToBigEndian<quint32>(size, length);
+  uLong crc = crc32(0, reinterpret_cast<const Bytef *>(type), 4);
+  if (size > 0) {
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(data), size);
+  }
+  char check[4];
+  qToBigEndian<quint32>(crc, check);
+  return output->write(length, 4) == 4 && output->write(type, 4) == 4 &&
+         (size == 0 || output->write(data, size) == size) &&
+         output->write(check, 4) == 4;
+}
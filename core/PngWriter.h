@@ -0,0 +1,74 @@
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <QByteArray>
+#include <QColor>
+#include <QIODevice>
+#include <QImage>
+#include <QRect>
+#include <QVector>
+#include <zlib.h>
+
+///
+/// \brief The PngWriter class streams a straight RGBA or a palette png to a
+/// device one row at a time, so the image never has to exist in memory as a
+/// whole. A row equal to the one before it is written with the Up filter,
+/// which turns the repeated rows of an upscaled sprite into zeros that
+/// compress to almost nothing.
+///
+/// It also writes animated pngs (APNG). Their frames are compressed with
+/// compressFrame beforehand, which is safe to call from several threads, and
+/// then written in order with writeFrame.
+///
+class PngWriter {
+public:
+  // What is left of an animation frame before the next one is drawn, and how
+  // a frame is drawn over what is left (APNG's dispose_op and blend_op)
+  enum Dispose { DisposeNone, DisposeBackground };
+  enum Blend { BlendSource, BlendOver };
+
+  struct Frame {
+    QRect rect;    // where the frame is drawn, in output pixels
+    int delay = 1; // shown for delay / delayScale seconds
+    int delayScale = 1;
+    Dispose dispose = DisposeNone;
+    Blend blend = BlendSource;
+    QByteArray data; // from compressFrame
+  };
+
+  explicit PngWriter(QIODevice *device, int level = Z_DEFAULT_COMPRESSION);
+  ~PngWriter();
+  bool begin(int width, int height);
+  bool begin(int width, int height, const QVector<QRgb> &palette);
+  bool writeRow(const uchar *row);
+  bool end();
+
+  bool beginAnimation(int width, int height, int frames);
+  bool writeFrame(const Frame &frame);
+  static QByteArray compressFrame(const QImage &image, int scale, int level);
+
+private:
+  static constexpr int chunkSize = 1 << 16; // bytes of deflate data per IDAT
+
+  bool writeHeader(int width, int height, int colorType,
+                   const QVector<QRgb> &palette);
+  bool start(int width, int height, int colorType, int bytesPerPixel,
+             const QVector<QRgb> &palette);
+  static void filterRow(const uchar *row, int rowSize, QByteArray &previous,
+                        QByteArray &filtered);
+  bool compress(const uchar *data, int size, int flush);
+  bool writeChunk(const char *type, const char *data, int size);
+
+  QIODevice *output;
+  int level; // zlib compression level, 0 to 9
+  z_stream stream;
+  bool started;
+  int rowSize;           // bytes in a row, without the filter byte
+  QByteArray previous;   // the last row written
+  QByteArray filtered;   // the row being written, after its filter byte
+  QByteArray compressed; // deflate output waiting to fill an IDAT chunk
+  int compressedSize;
+  int sequence; // next APNG sequence number, or -1 if not animating
+};
+
+#endif // PNGWRITER_H
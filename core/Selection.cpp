@@ -0,0 +1,772 @@
+#include "Selection.h"
+#include "Stroke.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+///
+/// \brief SelectionMask::SelectionMask creates an empty 0x0 mask
+///
+SelectionMask::SelectionMask() : SelectionMask(0, 0) {}
+
+///
+/// \brief SelectionMask::SelectionMask creates a mask with nothing selected
+/// \param width in pixels
+/// \param height in pixels
+///
+SelectionMask::SelectionMask(int width, int height) {
+  maskWidth = std::max(width, 0);
+  maskHeight = std::max(height, 0);
+  stride = (maskWidth + 63) / 64;
+  words.fill(0, stride * maskHeight);
+}
+
+int SelectionMask::width() const { return maskWidth; }
+
+int SelectionMask::height() const { return maskHeight; }
+
+QSize SelectionMask::size() const { return QSize(maskWidth, maskHeight); }
+
+///
+/// \brief SelectionMask::isEmpty
+/// \return true if no pixel is selected
+///
+bool SelectionMask::isEmpty() const {
+  for (quint64 word : words) {
+    if (word != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+///
+/// \brief SelectionMask::contains
+/// \return true if the pixel is selected; pixels outside the mask never are
+///
+bool SelectionMask::contains(int x, int y) const {
+  if (x < 0 || y < 0 || x >= maskWidth || y >= maskHeight) {
+    return false;
+  }
+  return (row(y)[x >> 6] >> (x & 63)) & 1;
+}
+
+///
+/// \brief SelectionMask::bounds
+/// \return The smallest rectangle holding every selected pixel, or a null
+/// rectangle if nothing is selected
+///
+QRect SelectionMask::bounds() const {
+  int left = maskWidth;
+  int right = -1;
+  int top = -1;
+  int bottom = -1;
+  for (int y = 0; y < maskHeight; y++) {
+    const quint64 *bits = row(y);
+    int first = -1;
+    int last = -1;
+    for (int i = 0; i < stride; i++) {
+      if (bits[i] != 0) {
+        if (first < 0) {
+          first = i;
+        }
+        last = i;
+      }
+    }
+    if (first < 0) {
+      continue;
+    }
+    if (top < 0) {
+      top = y;
+    }
+    bottom = y;
+    left = std::min(left,
+                    first * 64 + (int)qCountTrailingZeroBits(bits[first]));
+    right = std::max(right,
+                     last * 64 + 63 - (int)qCountLeadingZeroBits(bits[last]));
+  }
+  if (top < 0) {
+    return QRect();
+  }
+  return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+///
+/// \brief SelectionMask::nextSet finds the next selected pixel of a row
+/// \param y The row
+/// \param x The column to start searching from
+/// \return The column of the pixel, or the width if there is none
+///
+int SelectionMask::nextSet(int y, int x) const {
+  if (x >= maskWidth) {
+    return maskWidth;
+  }
+  const quint64 *bits = row(y);
+  int i = x >> 6;
+  quint64 word = bits[i] & (~0ull << (x & 63));
+  while (word == 0) {
+    if (++i == stride) {
+      return maskWidth;
+    }
+    word = bits[i];
+  }
+  return std::min(i * 64 + (int)qCountTrailingZeroBits(word), maskWidth);
+}
+
+///
+/// \brief SelectionMask::nextClear finds the next unselected pixel of a row
+/// \param y The row
+/// \param x The column to start searching from
+/// \return The column of the pixel, or the width if there is none
+///
+int SelectionMask::nextClear(int y, int x) const {
+  if (x >= maskWidth) {
+    return maskWidth;
+  }
+  const quint64 *bits = row(y);
+  int i = x >> 6;
+  quint64 word = ~bits[i] & (~0ull << (x & 63));
+  while (word == 0) {
+    if (++i == stride) {
+      return maskWidth;
+    }
+    word = ~bits[i];
+  }
+  return std::min(i * 64 + (int)qCountTrailingZeroBits(word), maskWidth);
+}
+
+///
+/// \brief SelectionMask::clear deselects every pixel
+///
+void SelectionMask::clear() { words.fill(0); }
+
+///
+/// \brief SelectionMask::fill selects every pixel
+///
+void SelectionMask::fill() {
+  words.fill(~0ull);
+  clearPadding();
+}
+
+///
+/// \brief SelectionMask::invert swaps selected and unselected pixels
+///
+void SelectionMask::invert() {
+  quint64 *bits = words.data();
+  for (qsizetype i = 0, count = words.size(); i < count; i++) {
+    bits[i] = ~bits[i];
+  }
+  clearPadding();
+}
+
+///
+/// \brief SelectionMask::setSpan selects a run of pixels, clipped to the mask
+/// \param y The row
+/// \param start The first column
+/// \param end One past the last column
+///
+void SelectionMask::setSpan(int y, int start, int end) {
+  start = std::max(start, 0);
+  end = std::min(end, maskWidth);
+  if (y < 0 || y >= maskHeight || start >= end) {
+    return;
+  }
+  quint64 *bits = row(y);
+  int first = start >> 6;
+  int last = (end - 1) >> 6;
+  quint64 firstMask = ~0ull << (start & 63);
+  quint64 lastMask = ~0ull >> (63 - ((end - 1) & 63));
+  if (first == last) {
+    bits[first] |= firstMask & lastMask;
+    return;
+  }
+  bits[first] |= firstMask;
+  for (int i = first + 1; i < last; i++) {
+    bits[i] = ~0ull;
+  }
+  bits[last] |= lastMask;
+}
+
+///
+/// \brief SelectionMask::addRect selects every pixel of a rectangle
+/// \param rect The rectangle, clipped to the mask
+///
+void SelectionMask::addRect(QRect rect) {
+  rect &= QRect(0, 0, maskWidth, maskHeight);
+  for (int y = rect.top(); y <= rect.bottom(); y++) {
+    setSpan(y, rect.left(), rect.right() + 1);
+  }
+}
+
+///
+/// \brief SelectionMask::addPolygon selects the pixels inside a closed path
+/// with the even-odd rule, plus the pixels on the path itself so that thin
+/// shapes are not lost.
+/// \param polygon The path, in pixels; the last point connects to the first
+///
+void SelectionMask::addPolygon(const QPolygon &polygon) {
+  if (polygon.isEmpty()) {
+    return;
+  }
+
+  // Fill each row between pairs of edge crossings.
+  QRect area = polygon.boundingRect() & QRect(0, 0, maskWidth, maskHeight);
+  QVector<double> crossings;
+  for (int y = area.top(); y <= area.bottom(); y++) {
+    crossings.clear();
+    for (int i = 0; i < polygon.size(); i++) {
+      QPoint a = polygon[i];
+      QPoint b = polygon[(i + 1) % polygon.size()];
+      if ((a.y() > y) != (b.y() > y)) {
+        crossings.append(a.x() + double(y - a.y()) * (b.x() - a.x()) /
+                                     (b.y() - a.y()));
+      }
+    }
+    std::sort(crossings.begin(), crossings.end());
+    for (int i = 0; i + 1 < crossings.size(); i += 2) {
+      setSpan(y, (int)std::ceil(crossings[i]),
+              (int)std::ceil(crossings[i + 1]));
+    }
+  }
+
+  QVector<QPoint> outline;
+  for (int i = 0; i < polygon.size(); i++) {
+    Stroke::rasterizeLine(polygon[i], polygon[(i + 1) % polygon.size()],
+                          outline);
+  }
+  for (QPoint point : outline) {
+    setSpan(point.y(), point.x(), point.x() + 1);
+  }
+}
+
+///
+/// \brief SelectionMask::unite selects the pixels selected in either mask
+/// \param other A mask of the same size
+///
+void SelectionMask::unite(const SelectionMask &other) {
+  if (other.size() != size()) {
+    return;
+  }
+  quint64 *bits = words.data();
+  const quint64 *source = other.words.constData();
+  for (qsizetype i = 0, count = words.size(); i < count; i++) {
+    bits[i] |= source[i];
+  }
+}
+
+///
+/// \brief SelectionMask::intersect keeps the pixels selected in both masks
+/// \param other A mask of the same size
+///
+void SelectionMask::intersect(const SelectionMask &other) {
+  if (other.size() != size()) {
+    return;
+  }
+  quint64 *bits = words.data();
+  const quint64 *source = other.words.constData();
+  for (qsizetype i = 0, count = words.size(); i < count; i++) {
+    bits[i] &= source[i];
+  }
+}
+
+///
+/// \brief SelectionMask::subtract deselects the pixels selected in the other
+/// mask
+/// \param other A mask of the same size
+///
+void SelectionMask::subtract(const SelectionMask &other) {
+  if (other.size() != size()) {
+    return;
+  }
+  quint64 *bits = words.data();
+  const quint64 *source = other.words.constData();
+  for (qsizetype i = 0, count = words.size(); i < count; i++) {
+    bits[i] &= ~source[i];
+  }
+}
+
+///
+/// \brief SelectionMask::copy
+/// \param rect The area to copy; parts outside the mask come back unselected
+/// \return A mask the size of the rectangle
+///
+SelectionMask SelectionMask::copy(QRect rect) const {
+  SelectionMask result(rect.width(), rect.height());
+  QRect area = rect & QRect(0, 0, maskWidth, maskHeight);
+  for (int y = area.top(); y <= area.bottom(); y++) {
+    for (int x = area.left(); x <= area.right(); x += 64) {
+      int count = std::min(64, area.right() + 1 - x);
+      result.orBits(y - rect.top(), x - rect.left(), readBits(y, x, count),
+                    count);
+    }
+  }
+  return result;
+}
+
+///
+/// \brief SelectionMask::paste adds the selected pixels of another mask,
+/// clipped to this one
+/// \param source The mask to add
+/// \param position Where the top left corner of the source goes
+///
+void SelectionMask::paste(const SelectionMask &source, QPoint position) {
+  QRect area =
+      QRect(position, source.size()) & QRect(0, 0, maskWidth, maskHeight);
+  for (int y = area.top(); y <= area.bottom(); y++) {
+    for (int x = area.left(); x <= area.right(); x += 64) {
+      int count = std::min(64, area.right() + 1 - x);
+      orBits(y, x,
+             source.readBits(y - position.y(), x - position.x(), count),
+             count);
+    }
+  }
+}
+
+///
+/// \brief SelectionMask::flipped
+/// \param orientation Qt::Horizontal mirrors left to right, Qt::Vertical top
+/// to bottom
+/// \return The mirrored mask
+///
+SelectionMask SelectionMask::flipped(Qt::Orientation orientation) const {
+  SelectionMask result(maskWidth, maskHeight);
+  for (int y = 0; y < maskHeight; y++) {
+    if (orientation == Qt::Vertical) {
+      std::copy(row(y), row(y) + stride, result.row(maskHeight - 1 - y));
+      continue;
+    }
+    for (int x = nextSet(y, 0); x < maskWidth;) {
+      int end = nextClear(y, x);
+      result.setSpan(y, maskWidth - end, maskWidth - x);
+      x = nextSet(y, end);
+    }
+  }
+  return result;
+}
+
+///
+/// \brief SelectionMask::rotated
+/// \return The mask turned 90 degrees clockwise
+///
+SelectionMask SelectionMask::rotated() const {
+  SelectionMask result(maskHeight, maskWidth);
+  for (int y = 0; y < maskHeight; y++) {
+    int column = maskHeight - 1 - y;
+    for (int x = nextSet(y, 0); x < maskWidth;) {
+      int end = nextClear(y, x);
+      for (; x < end; x++) {
+        result.row(x)[column >> 6] |= 1ull << (column & 63);
+      }
+      x = nextSet(y, end);
+    }
+  }
+  return result;
+}
+
+///
+/// \brief SelectionMask::toImage draws the selected pixels in one color, for
+/// showing the selection over the canvas
+/// \param color A premultiplied color
+/// \return A premultiplied image the size of the mask
+///
+QImage SelectionMask::toImage(QRgb color) const {
+  QImage image(maskWidth, maskHeight, QImage::Format_ARGB32_Premultiplied);
+  image.fill(0);
+  for (int y = 0; y < maskHeight; y++) {
+    QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+    for (int x = nextSet(y, 0); x < maskWidth;) {
+      int end = nextClear(y, x);
+      std::fill(line + x, line + end, color);
+      x = nextSet(y, end);
+    }
+  }
+  return image;
+}
+
+///
+/// \brief SelectionMask::similarPixels selects the area of pixels connected
+/// to the seed that have exactly its color, with a scanline flood fill
+/// \param image A 32-bit or an indexed layer image
+/// \param seed The pixel that was clicked
+/// \return A mask the size of the image
+///
+SelectionMask SelectionMask::similarPixels(const QImage &image, QPoint seed) {
+  SelectionMask result(image.width(), image.height());
+  if (!image.rect().contains(seed)) {
+    return result;
+  }
+  if (image.depth() == 8) {
+    result.floodFill<uchar>(image, seed);
+  } else {
+    result.floodFill<QRgb>(image, seed);
+  }
+  return result;
+}
+
+///
+/// \brief SelectionMask::floodFill selects the pixels connected to the seed
+/// that are equal to it
+/// \param image An image with one Pixel per pixel
+/// \param seed The start of the fill
+///
+template <typename Pixel>
+void SelectionMask::floodFill(const QImage &image, QPoint seed) {
+  const uchar *bits = image.constBits();
+  qsizetype bytesPerLine = image.bytesPerLine();
+  auto line = [&](int y) {
+    return reinterpret_cast<const Pixel *>(bits + y * bytesPerLine);
+  };
+  Pixel target = line(seed.y())[seed.x()];
+
+  QVector<QPoint> pending{seed};
+  while (!pending.isEmpty()) {
+    QPoint point = pending.takeLast();
+    int y = point.y();
+    if (contains(point.x(), y)) {
+      continue;
+    }
+
+    // Grow the run left and right, then queue the runs touching it on the
+    // rows above and below.
+    const Pixel *pixels = line(y);
+    int start = point.x();
+    int end = point.x() + 1;
+    while (start > 0 && pixels[start - 1] == target) {
+      start--;
+    }
+    while (end < maskWidth && pixels[end] == target) {
+      end++;
+    }
+    setSpan(y, start, end);
+
+    for (int next : {y - 1, y + 1}) {
+      if (next < 0 || next >= maskHeight) {
+        continue;
+      }
+      const Pixel *nextPixels = line(next);
+      int x = start;
+      while (x < end) {
+        if (nextPixels[x] != target || contains(x, next)) {
+          x++;
+          continue;
+        }
+        pending.append(QPoint(x, next));
+        while (x < end && nextPixels[x] == target) {
+          x++;
+        }
+      }
+    }
+  }
+}
+
+quint64 *SelectionMask::row(int y) { return words.data() + y * stride; }
+
+const quint64 *SelectionMask::row(int y) const {
+  return words.constData() + y * stride;
+}
+
+///
+/// \brief SelectionMask::readBits reads up to 64 bits of a row starting at any
+/// column
+/// \param y The row
+/// \param x The first column
+/// \param count The number of bits; x + count must not pass the width
+/// \return The bits, the first column in the lowest bit
+///
+quint64 SelectionMask::readBits(int y, int x, int count) const {
+  const quint64 *bits = row(y);
+  int i = x >> 6;
+  int shift = x & 63;
+  quint64 value = bits[i] >> shift;
+  if (shift != 0 && shift + count > 64) {
+    value |= bits[i + 1] << (64 - shift);
+  }
+  return count == 64 ? value : value & ((1ull << count) - 1);
+}
+
+///
+/// \brief SelectionMask::orBits selects the set bits of a value, written to a
+/// row starting at any column
+/// \param y The row
+/// \param x The first column
+/// \param bits The bits, the first column in the lowest bit
+/// \param count The number of bits; x + count must not pass the width
+///
+void SelectionMask::orBits(int y, int x, quint64 bits, int count) {
+  quint64 *target = row(y);
+  int i = x >> 6;
+  int shift = x & 63;
+  target[i] |= bits << shift;
+  if (shift != 0 && shift + count > 64) {
+    target[i + 1] |= bits >> (64 - shift);
+  }
+}
+
+///
+/// \brief SelectionMask::clearPadding clears the bits past the width in the
+/// last word of every row, so whole-word operations never select them
+///
+void SelectionMask::clearPadding() {
+  if ((maskWidth & 63) == 0) {
+    return;
+  }
+  quint64 keep = (1ull << (maskWidth & 63)) - 1;
+  for (int y = 0; y < maskHeight; y++) {
+    row(y)[stride - 1] &= keep;
+  }
+}
+
+///
+/// \brief Selection::Selection default constructor, with nothing selected
+///
+Selection::Selection() {
+  floating = false;
+  overlayColor = 0;
+  overlayStale = true;
+}
+
+///
+/// \brief Selection::resize clears the selection for a canvas of a new size
+/// \param width in pixels
+/// \param height in pixels
+///
+void Selection::resize(int width, int height) {
+  current = SelectionMask(width, height);
+  floating = false;
+  pixels = QImage();
+  shape = SelectionMask();
+  overlayStale = true;
+}
+
+const SelectionMask &Selection::mask() const { return current; }
+
+///
+/// \brief Selection::isEmpty
+/// \return true if nothing is selected and no pixels are floating
+///
+bool Selection::isEmpty() const { return !floating && current.isEmpty(); }
+
+QRect Selection::bounds() const { return current.bounds(); }
+
+bool Selection::contains(QPoint pixel) const {
+  return current.contains(pixel.x(), pixel.y());
+}
+
+///
+/// \brief Selection::select combines a new shape with the selection
+/// \param region A mask the size of the canvas
+/// \param mode How the shape is combined with the current selection
+///
+void Selection::select(const SelectionMask &region, Mode mode) {
+  switch (mode) {
+  case replace:
+    current.clear();
+    current.unite(region);
+    break;
+  case add:
+    current.unite(region);
+    break;
+  case subtract:
+    current.subtract(region);
+    break;
+  case intersect:
+    current.intersect(region);
+    break;
+  }
+  overlayStale = true;
+}
+
+void Selection::selectAll() {
+  current.fill();
+  overlayStale = true;
+}
+
+void Selection::clear() {
+  current.clear();
+  overlayStale = true;
+}
+
+void Selection::invert() {
+  current.invert();
+  overlayStale = true;
+}
+
+bool Selection::isFloating() const { return floating; }
+
+///
+/// \brief Selection::lift cuts the selected pixels out of the layer so they
+/// can be moved or transformed. Cut pixels become transparent, which is zero
+/// in both 32-bit and indexed layers.
+/// \param layer A 32-bit or an indexed layer image
+///
+void Selection::lift(QImage &layer) {
+  QRect rect = current.bounds();
+  if (floating || rect.isEmpty()) {
+    return;
+  }
+  shape = current.copy(rect);
+  pixels = QImage(rect.size(), layer.format());
+  pixels.setColorTable(layer.colorTable());
+  pixels.fill(0);
+  floatingPosition = rect.topLeft();
+
+  int bytesPerPixel = layer.depth() / 8;
+  for (int y = 0; y < rect.height(); y++) {
+    uchar *source =
+        layer.scanLine(rect.top() + y) + rect.left() * bytesPerPixel;
+    uchar *target = pixels.scanLine(y);
+    for (int x = shape.nextSet(y, 0); x < shape.width();) {
+      int end = shape.nextClear(y, x);
+      memcpy(target + x * bytesPerPixel, source + x * bytesPerPixel,
+             (end - x) * bytesPerPixel);
+      memset(source + x * bytesPerPixel, 0, (end - x) * bytesPerPixel);
+      x = shape.nextSet(y, end);
+    }
+  }
+  floating = true;
+  overlayStale = true;
+}
+
+///
+/// \brief Selection::moveTo places the floating pixels. Nothing is copied;
+/// the layer only changes when they are dropped.
+/// \param position The layer position of their top left corner
+///
+void Selection::moveTo(QPoint position) { floatingPosition = position; }
+
+///
+/// \brief Selection::transform flips or rotates the floating pixels in place.
+/// Rotation turns them about the center of their bounds.
+/// \param transform
+///
+void Selection::transform(Transform transform) {
+  if (!floating) {
+    return;
+  }
+  int width = pixels.width();
+  int height = pixels.height();
+  if (pixels.depth() == 8) {
+    pixels = transformed<uchar>(pixels, transform);
+  } else {
+    pixels = transformed<QRgb>(pixels, transform);
+  }
+
+  switch (transform) {
+  case flipHorizontal:
+    shape = shape.flipped(Qt::Horizontal);
+    break;
+  case flipVertical:
+    shape = shape.flipped(Qt::Vertical);
+    break;
+  case rotateClockwise:
+    shape = shape.rotated();
+    floatingPosition += QPoint((width - height) / 2, (height - width) / 2);
+    break;
+  }
+  overlayStale = true;
+}
+
+///
+/// \brief Selection::drop writes the floating pixels back into the layer,
+/// replacing what is under them, and selects where they landed
+/// \param layer The layer they were lifted from
+///
+void Selection::drop(QImage &layer) {
+  if (!floating) {
+    return;
+  }
+  QRect area = floatingBounds() & layer.rect();
+  int bytesPerPixel = layer.depth() / 8;
+  for (int y = area.top(); y <= area.bottom(); y++) {
+    int row = y - floatingPosition.y();
+    const uchar *source = pixels.constScanLine(row);
+    uchar *target = layer.scanLine(y);
+    int limit = area.right() + 1 - floatingPosition.x();
+    for (int x = shape.nextSet(row, area.left() - floatingPosition.x());
+         x < limit;) {
+      int end = std::min(shape.nextClear(row, x), limit);
+      memcpy(target + (floatingPosition.x() + x) * bytesPerPixel,
+             source + x * bytesPerPixel, (end - x) * bytesPerPixel);
+      x = shape.nextSet(row, end);
+    }
+  }
+
+  current.clear();
+  current.paste(shape, floatingPosition);
+  floating = false;
+  pixels = QImage();
+  shape = SelectionMask();
+  overlayStale = true;
+}
+
+QPoint Selection::position() const { return floatingPosition; }
+
+///
+/// \brief Selection::floatingBounds
+/// \return The area of the layer the floating pixels cover
+///
+QRect Selection::floatingBounds() const {
+  return floating ? QRect(floatingPosition, pixels.size()) : QRect();
+}
+
+const QImage &Selection::floatingImage() const { return pixels; }
+
+const SelectionMask &Selection::floatingMask() const { return shape; }
+
+///
+/// \brief Selection::overlay tints the mask shown in the editor: the floating
+/// mask while pixels float, otherwise the selection. The image is kept until
+/// the mask changes, so redrawing the editor during a stroke doesn't rebuild
+/// it.
+/// \param color The premultiplied tint
+/// \return The floating mask's image, to draw at floatingBounds(), or the
+/// selection's, to draw over the whole canvas
+///
+const QImage &Selection::overlay(QRgb color) {
+  if (overlayStale || color != overlayColor) {
+    overlayImage = floating ? shape.toImage(color) : current.toImage(color);
+    overlayColor = color;
+    overlayStale = false;
+  }
+  return overlayImage;
+}
+
+///
+/// \brief Selection::transformed flips or rotates an image with one Pixel per
+/// pixel, moving whole pixels only
+/// \param image
+/// \param transform
+/// \return The new image, with the same format and color table
+///
+template <typename Pixel>
+QImage Selection::transformed(const QImage &image, Transform transform) {
+  int width = image.width();
+  int height = image.height();
+  QImage result = transform == rotateClockwise
+                      ? QImage(height, width, image.format())
+                      : QImage(width, height, image.format());
+  result.setColorTable(image.colorTable());
+
+  for (int y = 0; y < height; y++) {
+    const Pixel *source =
+        reinterpret_cast<const Pixel *>(image.constScanLine(y));
+    switch (transform) {
+    case flipHorizontal:
+      std::reverse_copy(source, source + width,
+                        reinterpret_cast<Pixel *>(result.scanLine(y)));
+      break;
+    case flipVertical:
+      std::copy(source, source + width,
+                reinterpret_cast<Pixel *>(result.scanLine(height - 1 - y)));
+      break;
+    case rotateClockwise:
+      for (int x = 0; x < width; x++) {
+        reinterpret_cast<Pixel *>(result.scanLine(x))[height - 1 - y] =
+            source[x];
+      }
+      break;
+    }
+  }
+  return result;
+}
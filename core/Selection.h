@@ -0,0 +1,108 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <QImage>
+#include <QPoint>
+#include <QPolygon>
+#include <QRect>
+#include <QVector>
+
+///
+/// \brief A one bit per pixel mask packed into 64-bit words, one padded row of
+/// words per image row. Set operations and row copies work a word at a time.
+///
+class SelectionMask {
+public:
+  SelectionMask();
+  SelectionMask(int width, int height);
+  int width() const;
+  int height() const;
+  QSize size() const;
+  bool isEmpty() const;
+  bool contains(int x, int y) const;
+  QRect bounds() const;
+  int nextSet(int y, int x) const;
+  int nextClear(int y, int x) const;
+
+  void clear();
+  void fill();
+  void invert();
+  void setSpan(int y, int start, int end);
+  void addRect(QRect rect);
+  void addPolygon(const QPolygon &polygon);
+
+  void unite(const SelectionMask &other);
+  void intersect(const SelectionMask &other);
+  void subtract(const SelectionMask &other);
+
+  SelectionMask copy(QRect rect) const;
+  void paste(const SelectionMask &source, QPoint position);
+  SelectionMask flipped(Qt::Orientation orientation) const;
+  SelectionMask rotated() const;
+  QImage toImage(QRgb color) const;
+
+  static SelectionMask similarPixels(const QImage &image, QPoint seed);
+
+private:
+  quint64 *row(int y);
+  const quint64 *row(int y) const;
+  quint64 readBits(int y, int x, int count) const;
+  void orBits(int y, int x, quint64 bits, int count);
+  void clearPadding();
+  template <typename Pixel> void floodFill(const QImage &image, QPoint seed);
+
+  int maskWidth;
+  int maskHeight;
+  int stride; // words per row
+  QVector<quint64> words;
+};
+
+///
+/// \brief The Selection class is the selected area of the canvas. While it is
+/// being moved or transformed its pixels float above the layer in their own
+/// image, so dragging only changes an offset until they are dropped again.
+///
+class Selection {
+public:
+  enum Mode { replace, add, subtract, intersect };
+  enum Transform { flipHorizontal, flipVertical, rotateClockwise };
+
+  Selection();
+  void resize(int width, int height);
+  const SelectionMask &mask() const;
+  bool isEmpty() const;
+  QRect bounds() const;
+  bool contains(QPoint pixel) const;
+
+  void select(const SelectionMask &region, Mode mode);
+  void selectAll();
+  void clear();
+  void invert();
+
+  // Floating pixels
+  bool isFloating() const;
+  void lift(QImage &layer);
+  void moveTo(QPoint position);
+  void transform(Transform transform);
+  void drop(QImage &layer);
+  QPoint position() const;
+  QRect floatingBounds() const;
+  const QImage &floatingImage() const;
+  const SelectionMask &floatingMask() const;
+  const QImage &overlay(QRgb color);
+
+private:
+  template <typename Pixel>
+  static QImage transformed(const QImage &image, Transform transform);
+
+  SelectionMask current;
+  bool floating;
+  QImage pixels;           // lifted pixels, transparent outside the mask
+  SelectionMask shape;     // mask of the lifted pixels
+  QPoint floatingPosition; // layer position of the lifted pixels
+  QImage overlayImage;     // tinted copy of the shown mask, see overlay()
+  QRgb overlayColor;
+  bool overlayStale; // the shown mask changed since overlayImage was made
+};
+
+#endif // SELECTION_H
@@ -0,0 +1,210 @@
+#include "Stroke.h"
+#include <algorithm>
+#include <cstdlib>
+
+///
+/// \brief Stroke::Stroke default constructor
+///
+Stroke::Stroke() { active = false; }
+
+///
+/// \brief Stroke::begin starts a new stroke at the given pixel
+/// \param point The pixel under the mouse when the button was pressed
+///
+void Stroke::begin(QPoint point) {
+  active = true;
+  anchor = point;
+  pending.clear();
+  pending.append(point);
+  erased.clear();
+}
+
+///
+/// \brief Stroke::addPoint queues a mouse sample. It is connected to the
+/// previous sample the next time the stroke is applied.
+/// \param point The pixel under the mouse
+///
+void Stroke::addPoint(QPoint point) {
+  if (!active) {
+    begin(point);
+    return;
+  }
+  pending.append(point);
+}
+
+///
+/// \brief Stroke::end finishes the stroke, dropping any unapplied samples
+///
+void Stroke::end() {
+  active = false;
+  pending.clear();
+  erased.clear();
+}
+
+///
+/// \brief Stroke::isActive
+/// \return true between begin() and end()
+///
+bool Stroke::isActive() const { return active; }
+
+///
+/// \brief Stroke::hasPending
+/// \return true if there are samples that have not been written yet
+///
+bool Stroke::hasPending() const { return !pending.isEmpty(); }
+
+///
+/// \brief Stroke::pendingBounds
+/// \param stamp The brush stamp the samples will be applied with
+/// \return The area the next apply() can change, unclipped
+///
+QRect Stroke::pendingBounds(const BrushStamp &stamp) const {
+  if (pending.isEmpty()) {
+    return QRect();
+  }
+  int left = anchor.x();
+  int right = anchor.x();
+  int top = anchor.y();
+  int bottom = anchor.y();
+  for (QPoint point : pending) {
+    left = std::min(left, point.x());
+    right = std::max(right, point.x());
+    top = std::min(top, point.y());
+    bottom = std::max(bottom, point.y());
+  }
+  int origin = stamp.size / 2;
+  return QRect(QPoint(left - origin, top - origin),
+               QPoint(right - origin + stamp.size - 1,
+                      bottom - origin + stamp.size - 1));
+}
+
+///
+/// \brief Stroke::apply rasterizes every queued segment, stamps the brush at
+/// each of its pixels and writes the result straight into the image scanlines.
+/// The stamped runs are clipped, sorted and merged first so that every pixel
+/// of the batch is written exactly once. A partial erase is not idempotent, so
+/// pixels erased by an earlier batch of the same stroke are skipped as well.
+/// \param image A 32-bit premultiplied or an indexed layer image
+/// \param stamp The brush stamp
+/// \param mode paint overwrites with color, erase removes coverage
+/// \param color The premultiplied paint color, or the palette index for an
+/// indexed image; for erase only its alpha is used, as the eraser strength.
+/// Indexed pixels are always erased to the transparent index.
+///
+void Stroke::apply(QImage &image, const BrushStamp &stamp, Mode mode,
+                   QRgb color) {
+  if (pending.isEmpty()) {
+    return;
+  }
+
+  points.clear();
+  for (QPoint point : pending) {
+    rasterizeLine(anchor, point, points);
+    anchor = point;
+  }
+  pending.clear();
+
+  // Expand every point by the stamp and clip the runs to the image.
+  int width = image.width();
+  int height = image.height();
+  runs.clear();
+  for (QPoint point : points) {
+    for (const BrushStamp::Span &span : stamp.spans) {
+      int y = point.y() + span.y;
+      if (y < 0 || y >= height) {
+        continue;
+      }
+      int start = std::max(point.x() + span.x, 0);
+      int end = std::min(point.x() + span.x + span.length, width);
+      if (start < end) {
+        runs.append({y, start, end});
+      }
+    }
+  }
+  if (runs.isEmpty()) {
+    return;
+  }
+
+  std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) {
+    return a.y != b.y ? a.y < b.y : a.start < b.start;
+  });
+
+  // bits() detaches the image once for the whole batch.
+  uchar *bits = image.bits();
+  qsizetype bytesPerLine = image.bytesPerLine();
+  bool indexed = image.format() == QImage::Format_Indexed8;
+  bool trackErased = mode == Mode::erase && !indexed;
+  if (trackErased && erased.size() != qsizetype(width) * height) {
+    erased.resize(qsizetype(width) * height);
+  }
+  int i = 0;
+  while (i < runs.size()) {
+    Run merged = runs[i++];
+    while (i < runs.size() && runs[i].y == merged.y &&
+           runs[i].start <= merged.end) {
+      merged.end = std::max(merged.end, runs[i].end);
+      i++;
+    }
+
+    if (indexed) {
+      std::fill_n(bits + merged.y * bytesPerLine + merged.start,
+                  merged.end - merged.start,
+                  mode == Mode::paint ? uchar(color) : uchar(0));
+      continue;
+    }
+    QRgb *row = reinterpret_cast<QRgb *>(bits + merged.y * bytesPerLine) +
+                merged.start;
+    if (mode == Mode::paint) {
+      Brush::fillSpan(row, merged.end - merged.start, color);
+      continue;
+    }
+    // Erase the pixels of the run this stroke hasn't reached yet.
+    qsizetype rowStart = qsizetype(merged.y) * width;
+    int x = merged.start;
+    while (x < merged.end) {
+      if (erased.testBit(rowStart + x)) {
+        x++;
+        continue;
+      }
+      int start = x;
+      while (x < merged.end && !erased.testBit(rowStart + x)) {
+        erased.setBit(rowStart + x);
+        x++;
+      }
+      Brush::eraseSpan(row + (start - merged.start), x - start, qAlpha(color));
+    }
+  }
+}
+
+///
+/// \brief Stroke::rasterizeLine appends the pixels of the segment between two
+/// points using Bresenham's algorithm, including both end points.
+/// \param from The start of the segment
+/// \param to The end of the segment
+/// \param points The list to append to
+///
+void Stroke::rasterizeLine(QPoint from, QPoint to, QVector<QPoint> &points) {
+  int x = from.x();
+  int y = from.y();
+  int dx = std::abs(to.x() - x);
+  int dy = -std::abs(to.y() - y);
+  int stepX = x < to.x() ? 1 : -1;
+  int stepY = y < to.y() ? 1 : -1;
+  int error = dx + dy;
+
+  while (true) {
+    points.append(QPoint(x, y));
+    if (x == to.x() && y == to.y()) {
+      break;
+    }
+    int doubled = 2 * error;
+    if (doubled >= dy) {
+      error += dy;
+      x += stepX;
+    }
+    if (doubled <= dx) {
+      error += dx;
+      y += stepY;
+    }
+  }
+}
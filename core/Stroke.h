@@ -0,0 +1,47 @@
+#ifndef STROKE_H
+#define STROKE_H
+
+#include "Brush.h"
+#include <QBitArray>
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+///
+/// \brief The Stroke class turns the mouse samples of one drag into a
+/// continuous line. Samples are queued as they arrive and the segments between
+/// them are rasterized, stamped with the brush and written to the layer
+/// together, so a burst of mouse events costs a single pass over the layer.
+///
+class Stroke {
+public:
+  enum Mode { paint, erase };
+
+  Stroke();
+  void begin(QPoint point);
+  void addPoint(QPoint point);
+  void end();
+  bool isActive() const;
+  bool hasPending() const;
+  QRect pendingBounds(const BrushStamp &stamp) const;
+  void apply(QImage &image, const BrushStamp &stamp, Mode mode, QRgb color);
+
+  static void rasterizeLine(QPoint from, QPoint to, QVector<QPoint> &points);
+
+private:
+  struct Run {
+    int y;
+    int start;
+    int end;
+  };
+
+  bool active;
+  QPoint anchor; // last sample already written to the layer
+  QVector<QPoint> pending;
+  QVector<QPoint> points;
+  QVector<Run> runs;
+  QBitArray erased; // pixels the eraser has already reached in this stroke
+};
+
+#endif // STROKE_H
@@ -0,0 +1,15 @@
+# Include from a project linking the core library, after setting its own QT.
+CORE_OUT = $$shadowed($$PWD)
+win32:CONFIG(release, debug|release): CORE_OUT = $$CORE_OUT/release
+else:win32:CONFIG(debug, debug|release): CORE_OUT = $$CORE_OUT/debug
+
+QT += core gui concurrent
+CONFIG += c++17
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# The library is static, so its own dependencies are linked here too.
+LIBS += -L$$CORE_OUT -lspritecore -lz
+win32-msvc*: PRE_TARGETDEPS += $$CORE_OUT/spritecore.lib
+else: PRE_TARGETDEPS += $$CORE_OUT/libspritecore.a
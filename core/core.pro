@@ -0,0 +1,51 @@
+TEMPLATE = lib
+TARGET = spritecore
+
+# No widgets here: frames, tools, file I/O and export only need QImage and
+# QPainter, and batch exports create no QGuiApplication at all.
+QT = core gui concurrent
+
+CONFIG += c++17 staticlib
+
+LIBS += -lz
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    Atlas.cpp \
+    Batch.cpp \
+    Brush.cpp \
+    Export.cpp \
+    Frame.cpp \
+    GifReader.cpp \
+    History.cpp \
+    ImagePool.cpp \
+    Import.cpp \
+    MemoryReport.cpp \
+    Palette.cpp \
+    Pixel.cpp \
+    PngWriter.cpp \
+    Selection.cpp \
+    Stroke.cpp \
+    model.cpp
+
+HEADERS += \
+    Atlas.h \
+    Batch.h \
+    Brush.h \
+    Export.h \
+    Frame.h \
+    GifReader.h \
+    History.h \
+    ImagePool.h \
+    Import.h \
+    MemoryReport.h \
+    Palette.h \
+    Pixel.h \
+    PngWriter.h \
+    Selection.h \
+    Stroke.h \
+    gif.h \
+    model.h
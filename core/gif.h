@@ -0,0 +1,1428 @@
+//
+// gif.h
+// by Charlie Tangora
+// Public domain.
+// Email me : ctangora -at- gmail -dot- com
+//
+// This file offers a simple, very limited way to create animated GIFs directly in code.
+//
+// Those looking for particular cleverness are likely to be disappointed; it's pretty
+// much a straight-ahead implementation of the GIF format with optional Floyd-Steinberg
+// or ordered dithering. (It does at least use delta encoding - only the changed portions of each
+// frame are saved.)
+//
+// So resulting files are often quite large. The hope is that it will be handy nonetheless
+// as a quick and easily-integrated way for programs to spit out animations.
+//
+// Only RGBA8 is currently supported as an input format. (The alpha is ignored.)
+//
+// If capturing a buffer with a bottom-left origin (such as OpenGL), define GIF_FLIP_VERT
+// to automatically flip the buffer data when writing the image (the buffer itself is
+// unchanged.
+//
+// USAGE:
+// Create a GifWriter struct. Pass it to GifBegin() to initialize and write the header.
+// Pass subsequent frames to GifWriteFrame().
+// Finally, call GifEnd() to close the file handle and free memory.
+//
+
+#ifndef gif_h
+#define gif_h
+
+#include <stdio.h>   // for FILE*
+#include <string.h>  // for memcpy and bzero
+#include <stdint.h>  // for integer typedefs
+#include <stdbool.h> // for bool macros
+
+// Define these macros to hook into a custom memory allocator.
+// TEMP_MALLOC and TEMP_FREE will only be called in stack fashion - frees in the reverse order of mallocs
+// and any temp memory allocated by a function will be freed before it exits.
+// MALLOC and FREE are used only by GifBegin and GifEnd respectively (to allocate a buffer the size of the image, which
+// is used to find changed pixels for delta-encoding.)
+
+#ifndef GIF_TEMP_MALLOC
+#include <stdlib.h>
+#define GIF_TEMP_MALLOC malloc
+#endif
+
+#ifndef GIF_TEMP_FREE
+#include <stdlib.h>
+#define GIF_TEMP_FREE free
+#endif
+
+#ifndef GIF_MALLOC
+#include <stdlib.h>
+#define GIF_MALLOC malloc
+#endif
+
+#ifndef GIF_FREE
+#include <stdlib.h>
+#define GIF_FREE free
+#endif
+
+// GIF_REALLOC grows the byte buffers frames are encoded into. Memory from it is released with GIF_FREE.
+#ifndef GIF_REALLOC
+#include <stdlib.h>
+#define GIF_REALLOC realloc
+#endif
+
+const int kGifTransIndex = 0;
+
+// Values for the dither argument. true and false still mean Floyd-Steinberg and none.
+enum
+{
+    kGifDitherNone = 0,           // nearest palette color, every pixel independent
+    kGifDitherFloydSteinberg = 1, // error diffusion, serial
+    kGifDitherOrdered = 2,        // 8x8 Bayer threshold, every pixel independent
+};
+
+typedef struct
+{
+    int bitDepth;
+
+    uint8_t r[256];
+    uint8_t g[256];
+    uint8_t b[256];
+
+    // k-d tree over RGB space, organized in heap fashion
+    // i.e. left child of node i is node i*2, right child is node i*2+1
+    // nodes 256-511 are implicitly the leaves, containing a color
+    uint8_t treeSplitElt[256];
+    uint8_t treeSplit[256];
+} GifPalette;
+
+// max, min, and abs functions
+int GifIMax(int l, int r) { return l>r?l:r; }
+int GifIMin(int l, int r) { return l<r?l:r; }
+int GifIAbs(int i) { return i<0?-i:i; }
+
+// walks the k-d tree to pick the palette entry for a desired color.
+// Takes as in/out parameters the current best color and its error -
+// only changes them if it finds a better color in its subtree.
+// this is the major hotspot in the code at the moment.
+void GifGetClosestPaletteColor( GifPalette* pPal, int r, int g, int b, int* bestInd, int* bestDiff, int treeRoot )
+{
+    // base case, reached the bottom of the tree
+    if(treeRoot > (1<<pPal->bitDepth)-1)
+    {
+        int ind = treeRoot-(1<<pPal->bitDepth);
+        if(ind == kGifTransIndex) return;
+
+        // check whether this color is better than the current winner
+        int r_err = r - ((int32_t)pPal->r[ind]);
+        int g_err = g - ((int32_t)pPal->g[ind]);
+        int b_err = b - ((int32_t)pPal->b[ind]);
+        int diff = GifIAbs(r_err)+GifIAbs(g_err)+GifIAbs(b_err);
+
+        if(diff < *bestDiff)
+        {
+            *bestInd = ind;
+            *bestDiff = diff;
+        }
+
+        return;
+    }
+
+    // take the appropriate color (r, g, or b) for this node of the k-d tree
+    int comps[3]; comps[0] = r; comps[1] = g; comps[2] = b;
+    int splitComp = comps[pPal->treeSplitElt[treeRoot]];
+
+    int splitPos = pPal->treeSplit[treeRoot];
+    if(splitPos > splitComp)
+    {
+        // check the left subtree
+        GifGetClosestPaletteColor(pPal, r, g, b, bestInd, bestDiff, treeRoot*2);
+        if( *bestDiff > splitPos - splitComp )
+        {
+            // cannot prove there's not a better value in the right subtree, check that too
+            GifGetClosestPaletteColor(pPal, r, g, b, bestInd, bestDiff, treeRoot*2+1);
+        }
+    }
+    else
+    {
+        GifGetClosestPaletteColor(pPal, r, g, b, bestInd, bestDiff, treeRoot*2+1);
+        if( *bestDiff > splitComp - splitPos )
+        {
+            GifGetClosestPaletteColor(pPal, r, g, b, bestInd, bestDiff, treeRoot*2);
+        }
+    }
+}
+
+// Direct-mapped cache of nearest palette entries, filled as colors are looked up.
+// Pixel art repeats a few colors across a frame, so most lookups hit and skip the
+// k-d tree walk. Slots hold the full color, so a hit gives exactly the tree's answer.
+#define kGifColorCacheBits 15
+
+typedef struct
+{
+    uint32_t keys[1 << kGifColorCacheBits];   // 0x01rrggbb, or 0 for an empty slot
+    uint8_t indices[1 << kGifColorCacheBits]; // nearest palette entry of each key
+} GifColorCache;
+
+// Must be called again whenever the palette changes.
+void GifColorCacheInit( GifColorCache* cache )
+{
+    memset(cache->keys, 0, sizeof(cache->keys));
+}
+
+// The palette entry GifGetClosestPaletteColor picks from the root. cache may be NULL.
+int GifClosestPaletteIndex( GifPalette* pPal, GifColorCache* cache, int r, int g, int b )
+{
+    // error diffusion can push a desired color out of range, those aren't cached
+    if( !cache || (r|g|b) < 0 || (r|g|b) > 255 )
+        cache = NULL;
+
+    uint32_t key = 0x01000000u | (uint32_t)r << 16 | (uint32_t)g << 8 | (uint32_t)b;
+    uint32_t slot = (key * 2654435761u) >> (32 - kGifColorCacheBits);
+    if( cache && cache->keys[slot] == key )
+        return cache->indices[slot];
+
+    int32_t bestDiff = 1000000;
+    int32_t bestInd = 1;
+    GifGetClosestPaletteColor(pPal, r, g, b, &bestInd, &bestDiff, 1);
+    if( cache )
+    {
+        cache->keys[slot] = key;
+        cache->indices[slot] = (uint8_t)bestInd;
+    }
+    return bestInd;
+}
+
+void GifSwapPixels(uint8_t* image, int pixA, int pixB)
+{
+    uint8_t rA = image[pixA*4];
+    uint8_t gA = image[pixA*4+1];
+    uint8_t bA = image[pixA*4+2];
+    uint8_t aA = image[pixA*4+3];
+
+    uint8_t rB = image[pixB*4];
+    uint8_t gB = image[pixB*4+1];
+    uint8_t bB = image[pixB*4+2];
+    uint8_t aB = image[pixA*4+3];
+
+    image[pixA*4] = rB;
+    image[pixA*4+1] = gB;
+    image[pixA*4+2] = bB;
+    image[pixA*4+3] = aB;
+
+    image[pixB*4] = rA;
+    image[pixB*4+1] = gA;
+    image[pixB*4+2] = bA;
+    image[pixB*4+3] = aA;
+}
+
+// just the partition operation from quicksort
+int GifPartition(uint8_t* image, const int left, const int right, const int elt, int pivotIndex)
+{
+    const int pivotValue = image[(pivotIndex)*4+elt];
+    GifSwapPixels(image, pivotIndex, right-1);
+    int storeIndex = left;
+    bool split = 0;
+    for(int ii=left; ii<right-1; ++ii)
+    {
+        int arrayVal = image[ii*4+elt];
+        if( arrayVal < pivotValue )
+        {
+            GifSwapPixels(image, ii, storeIndex);
+            ++storeIndex;
+        }
+        else if( arrayVal == pivotValue )
+        {
+            if(split)
+            {
+                GifSwapPixels(image, ii, storeIndex);
+                ++storeIndex;
+            }
+            split = !split;
+        }
+    }
+    GifSwapPixels(image, storeIndex, right-1);
+    return storeIndex;
+}
+
+// Perform an incomplete sort, finding all elements above and below the desired median
+void GifPartitionByMedian(uint8_t* image, int left, int right, int com, int neededCenter)
+{
+    if(left < right-1)
+    {
+        int pivotIndex = left + (right-left)/2;
+
+        pivotIndex = GifPartition(image, left, right, com, pivotIndex);
+
+        // Only "sort" the section of the array that contains the median
+        if(pivotIndex > neededCenter)
+            GifPartitionByMedian(image, left, pivotIndex, com, neededCenter);
+
+        if(pivotIndex < neededCenter)
+            GifPartitionByMedian(image, pivotIndex+1, right, com, neededCenter);
+    }
+}
+
+// Builds a palette by creating a balanced k-d tree of all pixels in the image
+void GifSplitPalette(uint8_t* image, int numPixels, int firstElt, int lastElt, int splitElt, int splitDist, int treeNode, bool buildForDither, GifPalette* pal)
+{
+    if(lastElt <= firstElt || numPixels == 0)
+        return;
+
+    // base case, bottom of the tree
+    if(lastElt == firstElt+1)
+    {
+        if(buildForDither)
+        {
+            // Dithering needs at least one color as dark as anything
+            // in the image and at least one brightest color -
+            // otherwise it builds up error and produces strange artifacts
+            if( firstElt == 1 )
+            {
+                // special case: the darkest color in the image
+                uint32_t r=255, g=255, b=255;
+                for(int ii=0; ii<numPixels; ++ii)
+                {
+                    r = (uint32_t)GifIMin((int32_t)r, image[ii * 4 + 0]);
+                    g = (uint32_t)GifIMin((int32_t)g, image[ii * 4 + 1]);
+                    b = (uint32_t)GifIMin((int32_t)b, image[ii * 4 + 2]);
+                }
+
+                pal->r[firstElt] = (uint8_t)r;
+                pal->g[firstElt] = (uint8_t)g;
+                pal->b[firstElt] = (uint8_t)b;
+
+                return;
+            }
+
+            if( firstElt == (1 << pal->bitDepth)-1 )
+            {
+                // special case: the lightest color in the image
+                uint32_t r=0, g=0, b=0;
+                for(int ii=0; ii<numPixels; ++ii)
+                {
+                    r = (uint32_t)GifIMax((int32_t)r, image[ii * 4 + 0]);
+                    g = (uint32_t)GifIMax((int32_t)g, image[ii * 4 + 1]);
+                    b = (uint32_t)GifIMax((int32_t)b, image[ii * 4 + 2]);
+                }
+
+                pal->r[firstElt] = (uint8_t)r;
+                pal->g[firstElt] = (uint8_t)g;
+                pal->b[firstElt] = (uint8_t)b;
+
+                return;
+            }
+        }
+
+        // otherwise, take the average of all colors in this subcube
+        uint64_t r=0, g=0, b=0;
+        for(int ii=0; ii<numPixels; ++ii)
+        {
+            r += image[ii*4+0];
+            g += image[ii*4+1];
+            b += image[ii*4+2];
+        }
+
+        r += (uint64_t)numPixels / 2;  // round to nearest
+        g += (uint64_t)numPixels / 2;
+        b += (uint64_t)numPixels / 2;
+
+        r /= (uint64_t)numPixels;
+        g /= (uint64_t)numPixels;
+        b /= (uint64_t)numPixels;
+
+        pal->r[firstElt] = (uint8_t)r;
+        pal->g[firstElt] = (uint8_t)g;
+        pal->b[firstElt] = (uint8_t)b;
+
+        return;
+    }
+
+    // Find the axis with the largest range
+    int minR = 255, maxR = 0;
+    int minG = 255, maxG = 0;
+    int minB = 255, maxB = 0;
+    for(int ii=0; ii<numPixels; ++ii)
+    {
+        int r = image[ii*4+0];
+        int g = image[ii*4+1];
+        int b = image[ii*4+2];
+
+        if(r > maxR) maxR = r;
+        if(r < minR) minR = r;
+
+        if(g > maxG) maxG = g;
+        if(g < minG) minG = g;
+
+        if(b > maxB) maxB = b;
+        if(b < minB) minB = b;
+    }
+
+    int rRange = maxR - minR;
+    int gRange = maxG - minG;
+    int bRange = maxB - minB;
+
+    // and split along that axis. (incidentally, this means this isn't a "proper" k-d tree but I don't know what else to call it)
+    int splitCom = 1;
+    if(bRange > gRange) splitCom = 2;
+    if(rRange > bRange && rRange > gRange) splitCom = 0;
+
+    int subPixelsA = numPixels * (splitElt - firstElt) / (lastElt - firstElt);
+    int subPixelsB = numPixels-subPixelsA;
+
+    GifPartitionByMedian(image, 0, numPixels, splitCom, subPixelsA);
+
+    pal->treeSplitElt[treeNode] = (uint8_t)splitCom;
+    pal->treeSplit[treeNode] = image[subPixelsA*4+splitCom];
+
+    GifSplitPalette(image,              subPixelsA, firstElt, splitElt, splitElt-splitDist, splitDist/2, treeNode*2,   buildForDither, pal);
+    GifSplitPalette(image+subPixelsA*4, subPixelsB, splitElt, lastElt,  splitElt+splitDist, splitDist/2, treeNode*2+1, buildForDither, pal);
+}
+
+// Finds all pixels that have changed from the previous image and
+// moves them to the fromt of th buffer.
+// This allows us to build a palette optimized for the colors of the
+// changed pixels only.
+int GifPickChangedPixels( const uint8_t* lastFrame, uint8_t* frame, int numPixels )
+{
+    int numChanged = 0;
+    uint8_t* writeIter = frame;
+
+    for (int ii=0; ii<numPixels; ++ii)
+    {
+        if(lastFrame[0] != frame[0] ||
+           lastFrame[1] != frame[1] ||
+           lastFrame[2] != frame[2])
+        {
+            writeIter[0] = frame[0];
+            writeIter[1] = frame[1];
+            writeIter[2] = frame[2];
+            ++numChanged;
+            writeIter += 4;
+        }
+        lastFrame += 4;
+        frame += 4;
+    }
+
+    return numChanged;
+}
+
+// Creates a palette by placing all the image pixels in a k-d tree and then averaging the blocks at the bottom.
+// This is known as the "modified median split" technique
+void GifMakePalette( const uint8_t* lastFrame, const uint8_t* nextFrame, uint32_t width, uint32_t height, int bitDepth, bool buildForDither, GifPalette* pPal )
+{
+    pPal->bitDepth = bitDepth;
+
+    // SplitPalette is destructive (it sorts the pixels by color) so
+    // we must create a copy of the image for it to destroy
+    size_t imageSize = (size_t)(width * height * 4 * sizeof(uint8_t));
+    uint8_t* destroyableImage = (uint8_t*)GIF_TEMP_MALLOC(imageSize);
+    memcpy(destroyableImage, nextFrame, imageSize);
+
+    int numPixels = (int)(width * height);
+    if(lastFrame)
+        numPixels = GifPickChangedPixels(lastFrame, destroyableImage, numPixels);
+
+    const int lastElt = 1 << bitDepth;
+    const int splitElt = lastElt/2;
+    const int splitDist = splitElt/2;
+
+    GifSplitPalette(destroyableImage, numPixels, 1, lastElt, splitElt, splitDist, 1, buildForDither, pPal);
+
+    GIF_TEMP_FREE(destroyableImage);
+
+    // add the bottom node for the transparency index
+    pPal->treeSplit[1 << (bitDepth-1)] = 0;
+    pPal->treeSplitElt[1 << (bitDepth-1)] = 0;
+
+    pPal->r[0] = pPal->g[0] = pPal->b[0] = 0;
+}
+
+// Implements Floyd-Steinberg dithering, writes palette value to alpha
+void GifDitherImage( const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal, GifColorCache* cache = NULL )
+{
+    int numPixels = (int)(width * height);
+
+    // quantPixels initially holds color*256 for all pixels
+    // The extra 8 bits of precision allow for sub-single-color error values
+    // to be propagated
+    int32_t *quantPixels = (int32_t *)GIF_TEMP_MALLOC(sizeof(int32_t) * (size_t)numPixels * 4);
+
+    for( int ii=0; ii<numPixels*4; ++ii )
+    {
+        uint8_t pix = nextFrame[ii];
+        int32_t pix16 = (int32_t)(pix) * 256;
+        quantPixels[ii] = pix16;
+    }
+
+    for( uint32_t yy=0; yy<height; ++yy )
+    {
+        for( uint32_t xx=0; xx<width; ++xx )
+        {
+            int32_t* nextPix = quantPixels + 4*(yy*width+xx);
+            const uint8_t* lastPix = lastFrame? lastFrame + 4*(yy*width+xx) : NULL;
+
+            // Compute the colors we want (rounding to nearest)
+            int32_t rr = (nextPix[0] + 127) / 256;
+            int32_t gg = (nextPix[1] + 127) / 256;
+            int32_t bb = (nextPix[2] + 127) / 256;
+
+            // if it happens that we want the color from last frame, then just write out
+            // a transparent pixel
+            if( lastFrame &&
+               lastPix[0] == rr &&
+               lastPix[1] == gg &&
+               lastPix[2] == bb )
+            {
+                nextPix[0] = rr;
+                nextPix[1] = gg;
+                nextPix[2] = bb;
+                nextPix[3] = kGifTransIndex;
+                continue;
+            }
+
+            // Search the palete
+            int32_t bestInd = GifClosestPaletteIndex(pPal, cache, rr, gg, bb);
+
+            // Write the result to the temp buffer
+            int32_t r_err = nextPix[0] - (int32_t)(pPal->r[bestInd]) * 256;
+            int32_t g_err = nextPix[1] - (int32_t)(pPal->g[bestInd]) * 256;
+            int32_t b_err = nextPix[2] - (int32_t)(pPal->b[bestInd]) * 256;
+
+            nextPix[0] = pPal->r[bestInd];
+            nextPix[1] = pPal->g[bestInd];
+            nextPix[2] = pPal->b[bestInd];
+            nextPix[3] = bestInd;
+
+            // Propagate the error to the four adjacent locations
+            // that we haven't touched yet
+            int quantloc_7 = (int)(yy * width + xx + 1);
+            int quantloc_3 = (int)(yy * width + width + xx - 1);
+            int quantloc_5 = (int)(yy * width + width + xx);
+            int quantloc_1 = (int)(yy * width + width + xx + 1);
+
+            if(quantloc_7 < numPixels)
+            {
+                int32_t* pix7 = quantPixels+4*quantloc_7;
+                pix7[0] += GifIMax( -pix7[0], r_err * 7 / 16 );
+                pix7[1] += GifIMax( -pix7[1], g_err * 7 / 16 );
+                pix7[2] += GifIMax( -pix7[2], b_err * 7 / 16 );
+            }
+
+            if(quantloc_3 < numPixels)
+            {
+                int32_t* pix3 = quantPixels+4*quantloc_3;
+                pix3[0] += GifIMax( -pix3[0], r_err * 3 / 16 );
+                pix3[1] += GifIMax( -pix3[1], g_err * 3 / 16 );
+                pix3[2] += GifIMax( -pix3[2], b_err * 3 / 16 );
+            }
+
+            if(quantloc_5 < numPixels)
+            {
+                int32_t* pix5 = quantPixels+4*quantloc_5;
+                pix5[0] += GifIMax( -pix5[0], r_err * 5 / 16 );
+                pix5[1] += GifIMax( -pix5[1], g_err * 5 / 16 );
+                pix5[2] += GifIMax( -pix5[2], b_err * 5 / 16 );
+            }
+
+            if(quantloc_1 < numPixels)
+            {
+                int32_t* pix1 = quantPixels+4*quantloc_1;
+                pix1[0] += GifIMax( -pix1[0], r_err / 16 );
+                pix1[1] += GifIMax( -pix1[1], g_err / 16 );
+                pix1[2] += GifIMax( -pix1[2], b_err / 16 );
+            }
+        }
+    }
+
+    // Copy the palettized result to the output buffer
+    for( int ii=0; ii<numPixels*4; ++ii )
+    {
+        outFrame[ii] = (uint8_t)quantPixels[ii];
+    }
+
+    GIF_TEMP_FREE(quantPixels);
+}
+
+// 8x8 Bayer matrix: the order in which thresholds are crossed across a tile
+const uint8_t kGifBayer8[64] =
+{
+     0, 32,  8, 40,  2, 34, 10, 42,
+    48, 16, 56, 24, 50, 18, 58, 26,
+    12, 44,  4, 36, 14, 46,  6, 38,
+    60, 28, 52, 20, 62, 30, 54, 22,
+     3, 35, 11, 43,  1, 33,  9, 41,
+    51, 19, 59, 27, 49, 17, 57, 25,
+    15, 47,  7, 39, 13, 45,  5, 37,
+    63, 31, 55, 23, 61, 29, 53, 21,
+};
+
+// Implements ordered dithering, writes palette value to alpha.
+// Each pixel is offset by its Bayer threshold before the palette lookup, so unlike
+// Floyd-Steinberg it depends only on its own color and position: there is no error buffer,
+// and rows can be processed in any order or concurrently.
+void GifOrderedDitherImage( const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal, GifColorCache* cache = NULL )
+{
+    // Spread the thresholds over about one palette step. A uniform palette of n colors
+    // has cbrt(n) levels per channel; a median cut palette crowds its colors where the
+    // image is, so half of that spacing is closer.
+    int levels = 1;
+    while( levels*levels*levels < (1 << pPal->bitDepth) ) ++levels;
+    int spread = 128 / levels;
+
+    // The offset for every matrix entry, centered on zero
+    int offsets[64];
+    for( int ii=0; ii<64; ++ii )
+        offsets[ii] = (2*kGifBayer8[ii]+1) * spread / 128 - spread / 2;
+
+    for( uint32_t yy=0; yy<height; ++yy )
+    {
+        const int* rowOffsets = offsets + (yy & 7) * 8;
+        for( uint32_t xx=0; xx<width; ++xx )
+        {
+            // same as thresholding: an unchanged pixel is transparent
+            if(lastFrame &&
+               lastFrame[0] == nextFrame[0] &&
+               lastFrame[1] == nextFrame[1] &&
+               lastFrame[2] == nextFrame[2])
+            {
+                outFrame[0] = lastFrame[0];
+                outFrame[1] = lastFrame[1];
+                outFrame[2] = lastFrame[2];
+                outFrame[3] = kGifTransIndex;
+            }
+            else
+            {
+                int offset = rowOffsets[xx & 7];
+                int rr = GifIMin(255, GifIMax(0, nextFrame[0] + offset));
+                int gg = GifIMin(255, GifIMax(0, nextFrame[1] + offset));
+                int bb = GifIMin(255, GifIMax(0, nextFrame[2] + offset));
+
+                int32_t bestInd = GifClosestPaletteIndex(pPal, cache, rr, gg, bb);
+
+                outFrame[0] = pPal->r[bestInd];
+                outFrame[1] = pPal->g[bestInd];
+                outFrame[2] = pPal->b[bestInd];
+                outFrame[3] = (uint8_t)bestInd;
+            }
+
+            if(lastFrame) lastFrame += 4;
+            outFrame += 4;
+            nextFrame += 4;
+        }
+    }
+}
+
+// Picks palette colors for the image using simple thresholding, no dithering
+void GifThresholdImage( const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, GifPalette* pPal, GifColorCache* cache = NULL )
+{
+    uint32_t numPixels = width*height;
+    for( uint32_t ii=0; ii<numPixels; ++ii )
+    {
+        // if a previous color is available, and it matches the current color,
+        // set the pixel to transparent
+        if(lastFrame &&
+           lastFrame[0] == nextFrame[0] &&
+           lastFrame[1] == nextFrame[1] &&
+           lastFrame[2] == nextFrame[2])
+        {
+            outFrame[0] = lastFrame[0];
+            outFrame[1] = lastFrame[1];
+            outFrame[2] = lastFrame[2];
+            outFrame[3] = kGifTransIndex;
+        }
+        else
+        {
+            // palettize the pixel
+            int32_t bestInd = GifClosestPaletteIndex(pPal, cache, nextFrame[0], nextFrame[1], nextFrame[2]);
+
+            // Write the resulting color to the output buffer
+            outFrame[0] = pPal->r[bestInd];
+            outFrame[1] = pPal->g[bestInd];
+            outFrame[2] = pPal->b[bestInd];
+            outFrame[3] = (uint8_t)bestInd;
+        }
+
+        if(lastFrame) lastFrame += 4;
+        outFrame += 4;
+        nextFrame += 4;
+    }
+}
+
+// Exact palettes for images with few colors (pixel art). Instead of quantizing,
+// every distinct RGB value gets its own palette entry through a small
+// open-addressing hash table, and pixels map to their entry directly.
+// Entry 0 stays reserved for transparency, so up to 255 colors fit.
+#define kGifColorMapSlots 512
+
+typedef struct
+{
+    uint32_t keys[kGifColorMapSlots];   // 0x01rrggbb, or 0 for an empty slot
+    uint8_t indices[kGifColorMapSlots]; // palette entry of each key
+    int count;                          // entries used, including transparency
+    GifPalette pal;                     // pal.bitDepth is the smallest that fits
+} GifColorMap;
+
+void GifColorMapInit( GifColorMap* map )
+{
+    memset(map->keys, 0, sizeof(map->keys));
+    map->count = 1;
+    map->pal.bitDepth = 2; // the minimum LZW code size GIF allows
+    memset(map->pal.r, 0, sizeof(map->pal.r)); // unused entries are written as black
+    memset(map->pal.g, 0, sizeof(map->pal.g));
+    memset(map->pal.b, 0, sizeof(map->pal.b));
+}
+
+// finds the slot holding the color, or the empty slot where it belongs
+int GifColorMapSlot( const GifColorMap* map, uint32_t key )
+{
+    uint32_t slot = (key * 2654435761u) >> 23; // top 9 bits of a Fibonacci hash
+    while( map->keys[slot] && map->keys[slot] != key )
+        slot = (slot + 1) & (kGifColorMapSlots - 1);
+    return (int)slot;
+}
+
+// looks up a color, or -1 if it is not in the map
+int GifColorMapFind( const GifColorMap* map, uint8_t r, uint8_t g, uint8_t b )
+{
+    uint32_t key = 0x1000000u | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    int slot = GifColorMapSlot(map, key);
+    return map->keys[slot]? map->indices[slot] : -1;
+}
+
+// adds every color of an RGBA8 image to the map. Returns false once the map
+// would need more than 256 entries; the map should not be used after that.
+bool GifColorMapAddImage( GifColorMap* map, const uint8_t* image, uint32_t numPixels )
+{
+    uint32_t lastKey = 0;
+    for( uint32_t ii=0; ii<numPixels; ++ii, image += 4 )
+    {
+        uint32_t key = 0x1000000u | ((uint32_t)image[0] << 16) | ((uint32_t)image[1] << 8) | image[2];
+        if( key == lastKey ) continue; // runs of one color are the common case
+        lastKey = key;
+
+        int slot = GifColorMapSlot(map, key);
+        if( map->keys[slot] ) continue;
+        if( map->count == 256 ) return false;
+
+        map->keys[slot] = key;
+        map->indices[slot] = (uint8_t)map->count;
+        map->pal.r[map->count] = image[0];
+        map->pal.g[map->count] = image[1];
+        map->pal.b[map->count] = image[2];
+        ++map->count;
+        while( (1 << map->pal.bitDepth) < map->count ) ++map->pal.bitDepth;
+    }
+    return true;
+}
+
+// checks that every color of an RGBA8 image is already in the map
+bool GifColorMapHasImage( const GifColorMap* map, const uint8_t* image, uint32_t numPixels )
+{
+    uint32_t lastKey = 0;
+    for( uint32_t ii=0; ii<numPixels; ++ii, image += 4 )
+    {
+        uint32_t key = 0x1000000u | ((uint32_t)image[0] << 16) | ((uint32_t)image[1] << 8) | image[2];
+        if( key == lastKey ) continue;
+        lastKey = key;
+        if( !map->keys[GifColorMapSlot(map, key)] ) return false;
+    }
+    return true;
+}
+
+// Like GifThresholdImage, but every color is in the map so the mapping is a
+// lookup rather than a search, and lossless.
+void GifExactImage( const uint8_t* lastFrame, const uint8_t* nextFrame, uint8_t* outFrame, uint32_t width, uint32_t height, const GifColorMap* map )
+{
+    uint32_t numPixels = width*height;
+    uint32_t lastKey = 0;
+    uint8_t lastInd = kGifTransIndex;
+    for( uint32_t ii=0; ii<numPixels; ++ii )
+    {
+        if(lastFrame &&
+           lastFrame[0] == nextFrame[0] &&
+           lastFrame[1] == nextFrame[1] &&
+           lastFrame[2] == nextFrame[2])
+        {
+            outFrame[0] = lastFrame[0];
+            outFrame[1] = lastFrame[1];
+            outFrame[2] = lastFrame[2];
+            outFrame[3] = kGifTransIndex;
+        }
+        else
+        {
+            uint32_t key = 0x1000000u | ((uint32_t)nextFrame[0] << 16) | ((uint32_t)nextFrame[1] << 8) | nextFrame[2];
+            if( key != lastKey )
+            {
+                lastKey = key;
+                lastInd = map->indices[GifColorMapSlot(map, key)];
+            }
+            outFrame[0] = nextFrame[0];
+            outFrame[1] = nextFrame[1];
+            outFrame[2] = nextFrame[2];
+            outFrame[3] = lastInd;
+        }
+
+        if(lastFrame) lastFrame += 4;
+        outFrame += 4;
+        nextFrame += 4;
+    }
+}
+
+// Growable byte buffer that frames are encoded into. Encoding to memory instead of the file
+// lets frames be encoded on different threads and written out in order afterwards.
+typedef struct
+{
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+} GifBuffer;
+
+void GifBufferInit( GifBuffer* buf )
+{
+    buf->data = NULL;
+    buf->size = 0;
+    buf->capacity = 0;
+}
+
+void GifBufferFree( GifBuffer* buf )
+{
+    if(buf->data) GIF_FREE(buf->data);
+    GifBufferInit(buf);
+}
+
+void GifBufferReserve( GifBuffer* buf, size_t size )
+{
+    if( size <= buf->capacity ) return;
+    size_t capacity = buf->capacity? buf->capacity : 4096;
+    while( capacity < size ) capacity *= 2;
+    buf->data = (uint8_t*)GIF_REALLOC(buf->data, capacity);
+    buf->capacity = capacity;
+}
+
+void GifBufferPut( GifBuffer* buf, int byte )
+{
+    if( buf->size == buf->capacity ) GifBufferReserve(buf, buf->size + 1);
+    buf->data[buf->size++] = (uint8_t)byte;
+}
+
+void GifBufferWrite( GifBuffer* buf, const void* data, size_t size )
+{
+    if( !size ) return;
+    GifBufferReserve(buf, buf->size + size);
+    memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+}
+
+// Packs LZW codes into bytes. Codes are at most 12 bits, so a 64-bit accumulator takes a
+// whole code at once and full bytes are moved out afterwards.
+typedef struct
+{
+    uint64_t bits;      // pending bits, the oldest in the lowest bit
+    uint32_t bitCount;  // how many pending bits there are
+
+    uint32_t chunkIndex;
+    uint8_t chunk[255];   // bytes are collected here and written as one 255 byte sub-block
+} GifBitStatus;
+
+// write all bytes so far to the buffer as one sub-block
+void GifWriteChunk( GifBuffer* buf, GifBitStatus* stat )
+{
+    GifBufferPut(buf, (int)stat->chunkIndex);
+    GifBufferWrite(buf, stat->chunk, stat->chunkIndex);
+
+    stat->chunkIndex = 0;
+}
+
+void GifWriteCode( GifBuffer* buf, GifBitStatus* stat, uint32_t code, uint32_t length )
+{
+    stat->bits |= (uint64_t)code << stat->bitCount;
+    stat->bitCount += length;
+
+    while( stat->bitCount >= 8 )
+    {
+        stat->chunk[stat->chunkIndex++] = (uint8_t)stat->bits;
+        stat->bits >>= 8;
+        stat->bitCount -= 8;
+
+        if( stat->chunkIndex == 255 )
+        {
+            GifWriteChunk(buf, stat);
+        }
+    }
+}
+
+// The LZW dictionary maps (code of a run, next index) to the code of the longer run.
+// An open-addressing hash table over at most 4096 entries is 48KB, so creating and
+// clearing it is cheap compared to a 256-ary tree (2MB).
+#define kGifLzwSlots 8192
+
+typedef struct
+{
+    uint32_t keys[kGifLzwSlots];   // (1 << 20) | code << 8 | index, or 0 for an empty slot
+    uint16_t codes[kGifLzwSlots];
+} GifLzwDict;
+
+// finds the slot of a run, or the empty slot where it belongs
+uint32_t GifLzwSlot( const GifLzwDict* dict, uint32_t key )
+{
+    uint32_t slot = (key * 2654435761u) >> 19; // top 13 bits of a Fibonacci hash
+    while( dict->keys[slot] && dict->keys[slot] != key )
+        slot = (slot + 1) & (kGifLzwSlots - 1);
+    return slot;
+}
+
+// write a 256-color (8-bit) image palette to the file
+void GifWritePalette( const GifPalette* pPal, GifBuffer* buf )
+{
+    GifBufferPut(buf, 0);  // first color: transparency
+    GifBufferPut(buf, 0);
+    GifBufferPut(buf, 0);
+
+    for(int ii=1; ii<(1 << pPal->bitDepth); ++ii)
+    {
+        uint32_t r = pPal->r[ii];
+        uint32_t g = pPal->g[ii];
+        uint32_t b = pPal->b[ii];
+
+        GifBufferPut(buf, (int)r);
+        GifBufferPut(buf, (int)g);
+        GifBufferPut(buf, (int)b);
+    }
+}
+
+// write the graphics control extension that precedes each frame. It is written when the
+// frame is flushed, once repeats of the frame have been folded into its delay.
+void GifWriteGraphicsControl( FILE* f, uint32_t delay )
+{
+    fputc(0x21, f);
+    fputc(0xf9, f);
+    fputc(0x04, f);
+    fputc(0x05, f); // leave prev frame in place, this frame has transparency
+    fputc(delay & 0xff, f);
+    fputc((delay >> 8) & 0xff, f);
+    fputc(kGifTransIndex, f); // transparent color index
+    fputc(0, f);
+}
+
+// finds the rectangle of an index image (one palette index per pixel) that isn't the
+// transparent index, i.e. the pixels that differ from the previous frame. Returns false if
+// there are none.
+bool GifChangedRect( const uint8_t* indices, uint32_t width, uint32_t height, uint32_t* left, uint32_t* top, uint32_t* rectWidth, uint32_t* rectHeight )
+{
+    uint32_t minX = width, maxX = 0, minY = height, maxY = 0;
+    for( uint32_t yy=0; yy<height; ++yy )
+    {
+        const uint8_t* row = indices + (size_t)yy*width;
+        uint32_t xx = 0;
+        while( xx < width && row[xx] == kGifTransIndex ) ++xx;
+        if( xx == width ) continue;
+
+        uint32_t last = width-1;
+        while( row[last] == kGifTransIndex ) --last;
+
+        minX = GifIMin((int)minX, (int)xx);
+        maxX = GifIMax((int)maxX, (int)last);
+        if( minY == height ) minY = yy;
+        maxY = yy;
+    }
+    if( minY == height ) return false;
+
+    *left = minX;
+    *top = minY;
+    *rectWidth = maxX - minX + 1;
+    *rectHeight = maxY - minY + 1;
+    return true;
+}
+
+// write the image header, LZW-compress and write out the rectangle at left, top of an index
+// image (one palette index per pixel). Without a local palette the frame uses the global one, which must have the same bit depth.
+// Each pixel is written as a scale x scale block as the rows are compressed, so the canvas is
+// scale times the image size without an enlarged copy of the image ever being made.
+void GifWriteLzwImage(GifBuffer* buf, const uint8_t* indices, uint32_t imageWidth, uint32_t imageHeight, uint32_t left, uint32_t top,  uint32_t width, uint32_t height, const GifPalette* pPal, bool localPalette = true, uint32_t scale = 1)
+{
+    #ifdef GIF_FLIP_VERT
+    // the rectangle is in buffer rows, which run bottom to top on the canvas
+    uint32_t canvasTop = imageHeight - top - height;
+    #else
+    uint32_t canvasTop = top;
+    (void)imageHeight;
+    #endif
+
+    const uint32_t canvasLeft = left*scale;
+    canvasTop *= scale;
+    const uint32_t scaledWidth = width*scale;
+    const uint32_t scaledHeight = height*scale;
+
+    GifBufferPut(buf, 0x2c); // image descriptor block
+
+    GifBufferPut(buf, canvasLeft & 0xff);     // corner of image in canvas space
+    GifBufferPut(buf, (canvasLeft >> 8) & 0xff);
+    GifBufferPut(buf, canvasTop & 0xff);
+    GifBufferPut(buf, (canvasTop >> 8) & 0xff);
+
+    GifBufferPut(buf, scaledWidth & 0xff);    // width and height of image
+    GifBufferPut(buf, (scaledWidth >> 8) & 0xff);
+    GifBufferPut(buf, scaledHeight & 0xff);
+    GifBufferPut(buf, (scaledHeight >> 8) & 0xff);
+
+    //GifBufferPut(buf, 0); // no local color table, no transparency
+    //GifBufferPut(buf, 0x80); // no local color table, but transparency
+
+    if( localPalette )
+    {
+        GifBufferPut(buf, 0x80 + pPal->bitDepth-1); // local color table present, 2 ^ bitDepth entries
+        GifWritePalette(pPal, buf);
+    }
+    else
+    {
+        GifBufferPut(buf, 0); // use the global color table
+    }
+
+    const int minCodeSize = pPal->bitDepth;
+    const uint32_t clearCode = 1 << pPal->bitDepth;
+
+    GifBufferPut(buf, minCodeSize); // min code size 8 bits
+
+    GifLzwDict* dict = (GifLzwDict*)GIF_TEMP_MALLOC(sizeof(GifLzwDict));
+
+    memset(dict->keys, 0, sizeof(dict->keys));
+    int32_t curCode = -1;
+    uint32_t codeSize = (uint32_t)minCodeSize + 1;
+    uint32_t maxCode = clearCode+1;
+
+    GifBitStatus stat;
+    stat.bits = 0;
+    stat.bitCount = 0;
+    stat.chunkIndex = 0;
+
+    GifWriteCode(buf, &stat, clearCode, codeSize);  // start with a fresh LZW dictionary
+
+    for(uint32_t yy=0; yy<scaledHeight; ++yy)
+    {
+    #ifdef GIF_FLIP_VERT
+        // bottom-left origin image (such as an OpenGL capture)
+        const uint8_t* pixel = indices + (size_t)(top+height-1-yy/scale)*imageWidth+left;
+    #else
+        // top-left origin
+        const uint8_t* pixel = indices + (size_t)(top+yy/scale)*imageWidth+left;
+    #endif
+        uint32_t repeat = 0;
+
+        for(uint32_t xx=0; xx<scaledWidth; ++xx)
+        {
+            uint8_t nextValue = *pixel;
+            if( ++repeat == scale )
+            {
+                repeat = 0;
+                ++pixel;
+            }
+
+            // "loser mode" - no compression, every single code is followed immediately by a clear
+            //WriteCode( f, stat, nextValue, codeSize );
+            //WriteCode( f, stat, 256, codeSize );
+
+            if( curCode < 0 )
+            {
+                // first value in a new run
+                curCode = nextValue;
+                continue;
+            }
+
+            uint32_t key = (1u << 20) | ((uint32_t)curCode << 8) | nextValue;
+            uint32_t slot = GifLzwSlot(dict, key);
+            if( dict->keys[slot] )
+            {
+                // current run already in the dictionary
+                curCode = dict->codes[slot];
+            }
+            else
+            {
+                // finish the current run, write a code
+                GifWriteCode(buf, &stat, (uint32_t)curCode, codeSize);
+
+                // insert the new run into the dictionary
+                dict->keys[slot] = key;
+                dict->codes[slot] = (uint16_t)++maxCode;
+
+                if( maxCode >= (1ul << codeSize) )
+                {
+                    // dictionary entry count has broken a size barrier,
+                    // we need more bits for codes
+                    codeSize++;
+                }
+                if( maxCode == 4095 )
+                {
+                    // the dictionary is full, clear it out and begin anew
+                    GifWriteCode(buf, &stat, clearCode, codeSize); // clear tree
+
+                    memset(dict->keys, 0, sizeof(dict->keys));
+                    codeSize = (uint32_t)(minCodeSize + 1);
+                    maxCode = clearCode+1;
+                }
+
+                curCode = nextValue;
+            }
+        }
+    }
+
+    // compression footer
+    GifWriteCode(buf, &stat, (uint32_t)curCode, codeSize);
+    GifWriteCode(buf, &stat, clearCode, codeSize);
+    GifWriteCode(buf, &stat, clearCode + 1, (uint32_t)minCodeSize + 1);
+
+    // write out the last partial byte and chunk
+    if( stat.bitCount ) GifWriteCode(buf, &stat, 0, 8 - stat.bitCount);
+    if( stat.chunkIndex ) GifWriteChunk(buf, &stat);
+
+    GifBufferPut(buf, 0); // image block terminator
+
+    GIF_TEMP_FREE(dict);
+}
+
+typedef struct
+{
+    FILE* f;
+    uint8_t* oldImage;         // the last frame as displayed
+    uint8_t* lastImage;        // the last frame as it was given
+    bool firstFrame;
+    GifColorMap* globalColors; // NULL unless GifBegin was given a global palette
+    GifBuffer buffer;          // reused by GifWriteFrame
+    GifBuffer pending;         // the last frame, held back until its delay is final
+    uint32_t pendingDelay;
+    uint32_t scale;            // the canvas is the frame size times this
+} GifWriter;
+
+// Writes the held back frame with its final delay.
+void GifFlushFrame( GifWriter* writer )
+{
+    if( !writer->pending.size ) return;
+
+    GifWriteGraphicsControl(writer->f, writer->pendingDelay);
+    fwrite(writer->pending.data, 1, writer->pending.size, writer->f);
+    writer->pending.size = 0;
+}
+
+// Writes a 1x1 image that is entirely transparent: a frame that leaves the screen as it is.
+void GifWriteEmptyImage( GifBuffer* buf )
+{
+    GifPalette pal;
+    memset(&pal, 0, sizeof(pal));
+    pal.bitDepth = 2; // the minimum LZW code size GIF allows
+    const uint8_t index = kGifTransIndex;
+    GifWriteLzwImage(buf, &index, 1, 1, 0, 0, 1, 1, &pal);
+}
+
+// Queues an encoded frame (buf->size == 0 for a frame identical to the one before it).
+// Repeated frames aren't written again; their delay is added to the frame they repeat.
+void GifQueueFrame( GifWriter* writer, GifBuffer* buf, uint32_t delay, bool takeBuffer )
+{
+    if( !buf->size && writer->pending.size )
+    {
+        // A frame can't be shown for longer than 0xffff hundredths of a second. Past that the
+        // held frame is written with the longest delay, and empty frames carry on the rest, so
+        // the animation keeps its length.
+        uint64_t total = (uint64_t)writer->pendingDelay + delay;
+        while( total > 0xffff )
+        {
+            writer->pendingDelay = 0xffff;
+            GifFlushFrame(writer);
+            GifWriteEmptyImage(&writer->pending);
+            total -= 0xffff;
+        }
+        writer->pendingDelay = (uint32_t)total;
+        return;
+    }
+
+    GifFlushFrame(writer);
+    writer->pendingDelay = delay;
+    if( takeBuffer )
+    {
+        GifBuffer swap = writer->pending;
+        writer->pending = *buf;
+        *buf = swap;
+    }
+    else
+    {
+        GifBufferWrite(&writer->pending, buf->data, buf->size);
+    }
+}
+
+// A frame mapped to palette indices. Frames are encoded in three stages, so that most of the
+// work can be done on several frames at once:
+// - GifMapFrame picks the frame's palette and maps its pixels to it. It needs only the frame
+//   and the one given before it, so any number of frames can be mapped concurrently.
+// - GifDeltaFrame makes the pixels already shown in their color transparent. It depends on
+//   every earlier frame, so frames go through it in order, but it is a single cheap pass.
+// - GifWriteMappedFrame LZW-compresses what is left, again for any frames at once.
+// GifEncodeFrame runs the three in a row, and gives the same bytes however they are scheduled.
+typedef struct
+{
+    GifPalette pal;     // the frame's palette, a copy of the global one if !localPalette
+    bool localPalette;  // false if the frame is written with the global palette
+    uint8_t* indices;   // one palette index per pixel, from GIF_MALLOC
+} GifMappedFrame;
+
+// First stage: maps an RGBA8 image to a palette. Frames with at most 255 colors map exactly,
+// to the global colors if they hold the frame, otherwise the frame is quantized. A quantized
+// pixel that is the same as in lastImage, the frame given before (or NULL for the first frame),
+// is left transparent: the one on screen already stands for its color. Its palette covers the
+// other pixels only, unless Floyd-Steinberg dithering needs the whole image.
+void GifMapFrame( GifMappedFrame* frame, const uint8_t* lastImage, const uint8_t* image, uint32_t width, uint32_t height, int bitDepth = 8, int dither = kGifDitherNone, const GifColorMap* globalColors = NULL )
+{
+    uint32_t numPixels = width*height;
+    uint8_t* mapped = (uint8_t*)GIF_TEMP_MALLOC((size_t)numPixels*4);
+    GifColorMap* colors = (GifColorMap*)GIF_TEMP_MALLOC(sizeof(GifColorMap));
+    GifColorMapInit(colors);
+
+    // the palette of a frame where nothing changed is never used, but is written out the same
+    // by every encoder
+    memset(&frame->pal, 0, sizeof(frame->pal));
+    frame->localPalette = true;
+
+    // Exact fast path: frames with at most 255 colors need no quantization.
+    // Dithering is pointless when every color is exact.
+    if( globalColors && GifColorMapHasImage(globalColors, image, numPixels) )
+    {
+        GifExactImage(NULL, image, mapped, width, height, globalColors);
+        frame->pal = globalColors->pal;
+        frame->localPalette = false;
+    }
+    else if( GifColorMapAddImage(colors, image, numPixels) )
+    {
+        GifExactImage(NULL, image, mapped, width, height, colors);
+        frame->pal = colors->pal;
+    }
+    else
+    {
+        // Floyd-Steinberg may change unchanged pixels, so its palette covers the whole image.
+        bool diffuse = dither == kGifDitherFloydSteinberg;
+        GifMakePalette((diffuse? NULL : lastImage), image, width, height, bitDepth, dither != kGifDitherNone, &frame->pal);
+
+        GifColorCache* cache = (GifColorCache*)GIF_TEMP_MALLOC(sizeof(GifColorCache));
+        GifColorCacheInit(cache);
+        if(diffuse)
+            GifDitherImage(lastImage, image, mapped, width, height, &frame->pal, cache);
+        else if(dither == kGifDitherOrdered)
+            GifOrderedDitherImage(lastImage, image, mapped, width, height, &frame->pal, cache);
+        else
+            GifThresholdImage(lastImage, image, mapped, width, height, &frame->pal, cache);
+        GIF_TEMP_FREE(cache);
+    }
+
+    frame->indices = (uint8_t*)GIF_MALLOC(numPixels);
+    for( uint32_t ii=0; ii<numPixels; ++ii )
+        frame->indices[ii] = mapped[ii*4+3];
+
+    GIF_TEMP_FREE(colors);
+    GIF_TEMP_FREE(mapped);
+}
+
+// Second stage: frames must come through here in order. Pixels that would be drawn in the
+// color already on screen become transparent, and shown (RGBA8, alpha unused) is updated from
+// the previous frame as displayed to this one. For the first frame shown needn't be set, and
+// no pixel is made transparent since there is nothing on screen yet.
+void GifDeltaFrame( GifMappedFrame* frame, uint8_t* shown, uint32_t width, uint32_t height, bool firstFrame )
+{
+    const GifPalette* pPal = &frame->pal;
+    uint32_t numPixels = width*height;
+    for( uint32_t ii=0; ii<numPixels; ++ii, shown += 4 )
+    {
+        uint8_t ind = frame->indices[ii];
+        if( ind == kGifTransIndex ) continue;
+
+        if( !firstFrame &&
+            shown[0] == pPal->r[ind] &&
+            shown[1] == pPal->g[ind] &&
+            shown[2] == pPal->b[ind] )
+        {
+            frame->indices[ii] = kGifTransIndex;
+            continue;
+        }
+
+        shown[0] = pPal->r[ind];
+        shown[1] = pPal->g[ind];
+        shown[2] = pPal->b[ind];
+    }
+}
+
+// Third stage: writes the image descriptor, palette and LZW data into buf. Only the bounding
+// box of the pixels that aren't transparent is encoded; if there are none, nothing is written
+// and false is returned. The first frame covers the whole canvas. Later ones leave the
+// previous frame in place outside their rectangle, and inside it wherever they are transparent.
+// scale must be the one given to GifBegin.
+bool GifWriteMappedFrame( GifBuffer* buf, const GifMappedFrame* frame, uint32_t width, uint32_t height, bool firstFrame, uint32_t scale = 1 )
+{
+    uint32_t left = 0, top = 0, rectWidth = width, rectHeight = height;
+    bool changed = firstFrame || GifChangedRect(frame->indices, width, height, &left, &top, &rectWidth, &rectHeight);
+    if( changed )
+        GifWriteLzwImage(buf, frame->indices, width, height, left, top, rectWidth, rectHeight, &frame->pal, frame->localPalette, scale);
+    return changed;
+}
+
+// Releases the indices of a mapped frame. Freeing a frame twice, or one whose indices are
+// NULL, does nothing.
+void GifFreeMappedFrame( GifMappedFrame* frame )
+{
+    if( frame->indices ) GIF_FREE(frame->indices);
+    frame->indices = NULL;
+}
+
+// Encodes one frame into buf by running GifMapFrame, GifDeltaFrame and GifWriteMappedFrame.
+// This is everything GifWriteFrame does except writing to the file.
+// lastImage is the image given for the previous frame, or NULL for the first frame. shown holds
+// the previous frame as displayed and receives this one.
+// globalColors and scale must be the ones given to GifBegin.
+bool GifEncodeFrame( GifBuffer* buf, const uint8_t* lastImage, const uint8_t* image, uint8_t* shown, uint32_t width, uint32_t height, int bitDepth = 8, int dither = kGifDitherNone, const GifColorMap* globalColors = NULL, uint32_t scale = 1 )
+{
+    GifMappedFrame frame;
+    GifMapFrame(&frame, lastImage, image, width, height, bitDepth, dither, globalColors);
+    GifDeltaFrame(&frame, shown, width, height, !lastImage);
+    bool changed = GifWriteMappedFrame(buf, &frame, width, height, !lastImage, scale);
+    GifFreeMappedFrame(&frame);
+    return changed;
+}
+
+// Creates a gif file.
+// The input GIFWriter is assumed to be uninitialized.
+// The delay value is the time between frames in hundredths of a second - note that not all viewers pay much attention to this value.
+// If globalColors holds every color of every frame (see GifColorMapAddImage), it is written once
+// as the global palette and frames are mapped to it exactly, without local palettes.
+// Frames are width x height; the GIF shows each of their pixels as a scale x scale block.
+bool GifBegin( GifWriter* writer, const char* filename, uint32_t width, uint32_t height, uint32_t delay, int32_t bitDepth = 8, int dither = kGifDitherNone, const GifColorMap* globalColors = NULL, uint32_t scale = 1 )
+{
+    (void)bitDepth; (void)dither; // Mute "Unused argument" warnings
+
+    // the logical screen size is stored in 16 bits
+    if( (uint64_t)width*scale > 0xffff || (uint64_t)height*scale > 0xffff ) return false;
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1400)
+    writer->f = 0;
+    fopen_s(&writer->f, filename, "wb");
+#else
+    writer->f = fopen(filename, "wb");
+#endif
+    if(!writer->f) return false;
+
+    writer->firstFrame = true;
+
+    // allocate
+    writer->oldImage = (uint8_t*)GIF_MALLOC((size_t)width*height*4);
+    writer->lastImage = (uint8_t*)GIF_MALLOC((size_t)width*height*4);
+    GifBufferInit(&writer->buffer);
+    GifBufferInit(&writer->pending);
+    writer->pendingDelay = 0;
+    writer->scale = scale;
+    writer->globalColors = NULL;
+    if( globalColors )
+    {
+        writer->globalColors = (GifColorMap*)GIF_MALLOC(sizeof(GifColorMap));
+        memcpy(writer->globalColors, globalColors, sizeof(GifColorMap));
+    }
+
+    fputs("GIF89a", writer->f);
+
+    // screen descriptor
+    fputc((width*scale) & 0xff, writer->f);
+    fputc(((width*scale) >> 8) & 0xff, writer->f);
+    fputc((height*scale) & 0xff, writer->f);
+    fputc(((height*scale) >> 8) & 0xff, writer->f);
+
+    if( globalColors )
+    {
+        fputc(0xf0 + globalColors->pal.bitDepth-1, writer->f); // unsorted global color table, 2 ^ bitDepth entries
+        fputc(0, writer->f);     // background color
+        fputc(0, writer->f);     // pixels are square
+        GifWritePalette(&globalColors->pal, &writer->buffer);
+        fwrite(writer->buffer.data, 1, writer->buffer.size, writer->f);
+        writer->buffer.size = 0;
+    }
+    else
+    {
+        fputc(0xf0, writer->f);  // there is an unsorted global color table of 2 entries
+        fputc(0, writer->f);     // background color
+        fputc(0, writer->f);     // pixels are square (we need to specify this because it's 1989)
+
+        // now the "global" palette (really just a dummy palette)
+        // color 0: black
+        fputc(0, writer->f);
+        fputc(0, writer->f);
+        fputc(0, writer->f);
+        // color 1: also black
+        fputc(0, writer->f);
+        fputc(0, writer->f);
+        fputc(0, writer->f);
+    }
+
+    if( delay != 0 )
+    {
+        // animation header
+        fputc(0x21, writer->f); // extension
+        fputc(0xff, writer->f); // application specific
+        fputc(11, writer->f); // length 11
+        fputs("NETSCAPE2.0", writer->f); // yes, really
+        fputc(3, writer->f); // 3 bytes of NETSCAPE2.0 data
+
+        fputc(1, writer->f); // JUST BECAUSE
+        fputc(0, writer->f); // loop infinitely (byte 0)
+        fputc(0, writer->f); // loop infinitely (byte 1)
+
+        fputc(0, writer->f); // block terminator
+    }
+
+    return true;
+}
+
+// Writes out a new frame to a GIF in progress.
+// The GIFWriter should have been created by GIFBegin.
+// AFAIK, it is legal to use different bit depths for different frames of an image -
+// this may be handy to save bits in animations that don't change much.
+// Frames with at most 255 colors are written losslessly with the smallest bit depth
+// that fits, ignoring bitDepth and dither.
+bool GifWriteFrame( GifWriter* writer, const uint8_t* image, uint32_t width, uint32_t height, uint32_t delay, int bitDepth = 8, int dither = kGifDitherNone )
+{
+    if(!writer->f) return false;
+
+    const uint8_t* lastImage = writer->firstFrame? NULL : writer->lastImage;
+    writer->firstFrame = false;
+
+    writer->buffer.size = 0;
+    GifEncodeFrame(&writer->buffer, lastImage, image, writer->oldImage, width, height, bitDepth, dither, writer->globalColors, writer->scale);
+    memcpy(writer->lastImage, image, (size_t)width*height*4);
+    GifQueueFrame(writer, &writer->buffer, delay, true);
+
+    return true;
+}
+
+// Writes out a frame encoded by GifEncodeFrame or GifWriteMappedFrame. Frames must be written in order, and a GIF
+// should be written either entirely with GifWriteFrame or entirely with this.
+bool GifWriteEncodedFrame( GifWriter* writer, GifBuffer* buf, uint32_t delay )
+{
+    if(!writer->f) return false;
+
+    GifQueueFrame(writer, buf, delay, false);
+    writer->firstFrame = false;
+
+    return true;
+}
+
+// Writes the EOF code, closes the file handle, and frees temp memory used by a GIF.
+// Many if not most viewers will still display a GIF properly if the EOF code is missing,
+// but it's still a good idea to write it out.
+bool GifEnd( GifWriter* writer )
+{
+    if(!writer->f) return false;
+
+    GifFlushFrame(writer);
+    fputc(0x3b, writer->f); // end of file
+    fclose(writer->f);
+    GIF_FREE(writer->oldImage);
+    GIF_FREE(writer->lastImage);
+    if(writer->globalColors) GIF_FREE(writer->globalColors);
+    GifBufferFree(&writer->buffer);
+    GifBufferFree(&writer->pending);
+
+    writer->f = NULL;
+    writer->oldImage = NULL;
+    writer->lastImage = NULL;
+    writer->globalColors = NULL;
+
+    return true;
+}
+
+#endif
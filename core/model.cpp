@@ -0,0 +1,1555 @@
+/**
+ *Model class for the sprite editor - handles all of the underlying logic
+ **/
+
+#include "model.h"
+#include "GifReader.h"
+#include "Import.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QPointF>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <stdlib.h>
+#include <unistd.h>
+
+Model::Model(QObject *parent) : QObject{parent} {
+  // Presets when application opens.
+  imageSize = 8;
+  height = imageSize;
+  width = imageSize;
+  frames.push_back(std::make_unique<Frame>(imageSize));
+  currentFrame = frames[0].get();
+  indexStale = true;
+  rebuilds = 0;
+  currentColor = QColor{255, 255, 255, 0};
+  currentAlpha = 255;
+  currentTool = Tool::cursor;
+  draw = false;
+  selection.resize(imageSize, imageSize);
+  selectionMode = Selection::replace;
+  selecting = false;
+  indexed = false;
+
+  // Mouse moves that arrive before the event loop goes idle are drawn as one
+  // batch.
+  strokeTimer.setSingleShot(true);
+  strokeTimer.setInterval(0);
+  connect(&strokeTimer, &QTimer::timeout, this, &Model::applyStroke);
+
+  // Set up first frame:
+  currentFrameNum = 1;
+  frameRate = 1;
+  currentPreviewFrame = 0;
+  addFrameIndex = 1;
+
+  displayNextPreviewFrame();
+  emit setFrameHighlight(1);
+}
+
+// ***TOOLBOX AND EDITING***
+
+///
+/// \brief Model::cursorButtonClicked - sets the current tool to cursor
+///
+void Model::cursorButtonClicked() {
+  currentTool = Tool::cursor;
+  resetToolButtons();
+  emit setCursorButton(
+      QString("QToolButton {background-color: rgb(200, 200, 255);}"));
+}
+
+///
+/// \brief Model::penButtonClicked - sets the current tool to pen
+///
+void Model::penButtonClicked() {
+  currentTool = Tool::pen;
+  resetToolButtons();
+  emit setPenButton(
+      QString("QToolButton {background-color: rgb(200, 200, 255);}"));
+}
+
+///
+/// \brief Model::eraserButtonClicked - sets the current tool to eraser
+///
+void Model::eraserButtonClicked() {
+  currentTool = Tool::eraser;
+  resetToolButtons();
+  emit setEraserButton(
+      QString("QToolButton {background-color: rgb(200, 200, 255);}"));
+}
+
+///
+/// \brief Model::bucketButtonClicked - sets the current tool to bucket
+///
+void Model::bucketButtonClicked() {
+  currentTool = Tool::bucket;
+  resetToolButtons();
+  emit setBucketButton(
+      QString("QToolButton {background-color: rgb(200, 200, 255);}"));
+}
+
+///
+/// \brief Model::rectSelectClicked - sets the current tool to the rectangle
+/// selection
+///
+void Model::rectSelectClicked() {
+  currentTool = Tool::rectSelect;
+  resetToolButtons();
+}
+
+///
+/// \brief Model::lassoSelectClicked - sets the current tool to the lasso
+/// selection
+///
+void Model::lassoSelectClicked() {
+  currentTool = Tool::lassoSelect;
+  resetToolButtons();
+}
+
+///
+/// \brief Model::magicWandClicked - sets the current tool to the magic wand,
+/// which selects the area of one color under the mouse
+///
+void Model::magicWandClicked() {
+  currentTool = Tool::magicWand;
+  resetToolButtons();
+}
+
+///
+/// \brief Model::resetToolButtons - visually deselects the tools from the
+/// toolbox
+///
+void Model::resetToolButtons() {
+  emit setCursorButton(
+      QString("QToolButton {background-color: rgb(255, 255, 255);}"));
+  emit setPenButton(
+      QString("QToolButton {background-color: rgb(255, 255, 255);}"));
+  emit setEraserButton(
+      QString("QToolButton {background-color: rgb(255, 255, 255);}"));
+  emit setBucketButton(
+      QString("QToolButton {background-color: rgb(255, 255, 255);}"));
+}
+
+///
+/// \brief Model::editFramePixels - edits the current layer of the current
+/// frame. The edits made to the current layer are determined by the current
+/// tool that is selected. The cursor tool moves the selected pixels, the
+/// selection tools change the selection, the bucket makes the entire layer one
+/// color, the pen fills selected pixels with the current color selected, and
+/// the eraser removes color from selected pixels. Pen and eraser samples are
+/// queued on the stroke and written together by applyStroke once the pending
+/// mouse events have been handled.
+/// \param event
+///
+void Model::editFramePixels(QMouseEvent *event) {
+  // The cursor tool drags the selected pixels around.
+  if (currentTool == Tool::cursor) {
+    moveSelection(event);
+    return;
+  }
+  if (currentTool == Tool::rectSelect || currentTool == Tool::lassoSelect ||
+      currentTool == Tool::magicWand) {
+    editSelection(event);
+    return;
+  }
+
+  // Set the entire layer to the selected color. The layer only changes on the
+  // click, so following mouse moves are ignored.
+  if (currentTool == Tool::bucket) {
+    if (event->type() != QEvent::MouseButtonPress) {
+      return;
+    }
+    int index = indexed ? paletteIndex() : Palette::transparent;
+    QImage &image = currentFrame->currentLayer->image;
+    history.beginPixels(currentFrameNum - 1, currentFrame->currentLayerNum,
+                        image);
+    history.capture(image, image.rect());
+    if (indexed) {
+      image.fill(index);
+    } else {
+      image.fill(QColor{currentColor.red(), currentColor.green(),
+                        currentColor.blue(), currentAlpha});
+    }
+    history.endPixels();
+    updateImageEditor();
+    return;
+  }
+
+  // Queue the pixel under the mouse; the segment from the previous sample is
+  // filled in when the stroke is applied.
+  QPoint pixel = mapToPixel(event->position());
+  if (stroke.isActive()) {
+    stroke.addPoint(pixel);
+  } else {
+    history.beginPixels(currentFrameNum - 1, currentFrame->currentLayerNum,
+                        currentFrame->currentLayer->image);
+    stroke.begin(pixel);
+  }
+  if (!strokeTimer.isActive()) {
+    strokeTimer.start();
+  }
+}
+
+///
+/// \brief Model::applyStroke - writes every queued stroke sample to the current
+/// layer and refreshes the editor once for the whole batch.
+///
+void Model::applyStroke() {
+  strokeTimer.stop();
+  if (!stroke.hasPending()) {
+    return;
+  }
+
+  // Save the tiles the batch can touch before they change.
+  history.capture(currentFrame->currentLayer->image,
+                  stroke.pendingBounds(brush.stamp()));
+
+  // The pen stores the true color (color combined with the alpha), or its
+  // palette index in an indexed project. The eraser removes as much coverage as
+  // the alpha asks for.
+  if (currentTool == Tool::pen) {
+    QRgb color = indexed ? paletteIndex()
+                         : qPremultiply(qRgba(currentColor.red(),
+                                              currentColor.green(),
+                                              currentColor.blue(),
+                                              currentAlpha));
+    stroke.apply(currentFrame->currentLayer->image, brush.stamp(),
+                 Stroke::paint, color);
+  } else {
+    stroke.apply(currentFrame->currentLayer->image, brush.stamp(),
+                 Stroke::erase, qRgba(0, 0, 0, currentAlpha));
+  }
+  updateImageEditor();
+}
+
+///
+/// \brief Model::editSelection - drags out a rectangle or lasso, or selects the
+/// area under the magic wand. Holding shift adds to the selection, alt
+/// subtracts from it and both together intersect with it.
+/// \param event
+///
+void Model::editSelection(QMouseEvent *event) {
+  QPoint pixel = mapToPixel(event->position());
+  if (event->type() == QEvent::MouseButtonPress) {
+    bool shift = event->modifiers().testFlag(Qt::ShiftModifier);
+    bool alt = event->modifiers().testFlag(Qt::AltModifier);
+    if (shift && alt) {
+      selectionMode = Selection::intersect;
+    } else if (shift) {
+      selectionMode = Selection::add;
+    } else if (alt) {
+      selectionMode = Selection::subtract;
+    } else {
+      selectionMode = Selection::replace;
+    }
+
+    if (currentTool == Tool::magicWand) {
+      selection.select(SelectionMask::similarPixels(
+                           currentFrame->currentLayer->image, pixel),
+                       selectionMode);
+      updateImageEditor();
+      return;
+    }
+    selecting = true;
+    selectStart = pixel;
+    selectEnd = pixel;
+    lassoPath.clear();
+    lassoPath.append(pixel);
+  } else if (selecting) {
+    selectEnd = pixel;
+    if (currentTool == Tool::lassoSelect && lassoPath.last() != pixel) {
+      lassoPath.append(pixel);
+    }
+  }
+  updateImageEditor();
+}
+
+///
+/// \brief Model::moveSelection - pressing inside the selection lifts its pixels
+/// off the layer, dragging moves them and releasing drops them in place. Only
+/// the floating offset changes while dragging.
+/// \param event
+///
+void Model::moveSelection(QMouseEvent *event) {
+  QPoint pixel = mapToPixel(event->position());
+  if (event->type() == QEvent::MouseButtonPress) {
+    if (!selection.contains(pixel)) {
+      return;
+    }
+    QImage &image = currentFrame->currentLayer->image;
+    history.beginPixels(currentFrameNum - 1, currentFrame->currentLayerNum,
+                        image);
+    history.capture(image, selection.bounds());
+    selection.lift(image);
+    selectStart = pixel;
+    floatingStart = selection.position();
+  } else if (selection.isFloating()) {
+    selection.moveTo(floatingStart + pixel - selectStart);
+  } else {
+    return;
+  }
+  updateImageEditor();
+}
+
+///
+/// \brief Model::finishSelection - drops the pixels being moved, or applies the
+/// rectangle or lasso that was dragged out, when the mouse is released
+///
+void Model::finishSelection() {
+  if (selection.isFloating()) {
+    QImage &image = currentFrame->currentLayer->image;
+    history.capture(image, selection.floatingBounds());
+    selection.drop(image);
+    history.endPixels();
+    updateImageEditor();
+  }
+  if (!selecting) {
+    return;
+  }
+  selecting = false;
+  SelectionMask shape(imageSize, imageSize);
+  if (currentTool == Tool::rectSelect) {
+    shape.addRect(QRect(QPoint(std::min(selectStart.x(), selectEnd.x()),
+                               std::min(selectStart.y(), selectEnd.y())),
+                        QPoint(std::max(selectStart.x(), selectEnd.x()),
+                               std::max(selectStart.y(), selectEnd.y()))));
+  } else {
+    shape.addPolygon(lassoPath);
+  }
+  selection.select(shape, selectionMode);
+  updateImageEditor();
+}
+
+///
+/// \brief Model::transformSelection - flips or rotates the selected pixels of
+/// the current layer, or the whole layer if nothing is selected
+/// \param transform
+///
+void Model::transformSelection(Selection::Transform transform) {
+  if (draw) {
+    return;
+  }
+  bool wholeLayer = selection.isEmpty();
+  if (wholeLayer) {
+    selection.selectAll();
+  }
+
+  QImage &image = currentFrame->currentLayer->image;
+  history.beginPixels(currentFrameNum - 1, currentFrame->currentLayerNum,
+                      image);
+  history.capture(image, selection.bounds());
+  selection.lift(image);
+  selection.transform(transform);
+  history.capture(image, selection.floatingBounds());
+  selection.drop(image);
+  history.endPixels();
+
+  if (wholeLayer) {
+    selection.clear();
+  }
+  updateImageEditor();
+}
+
+///
+/// \brief Model::drawSelection - draws the floating pixels, a tint over the
+/// selected area and the outline being dragged out on top of the editor image
+/// \param editor The layer image scaled to the editor window
+///
+void Model::drawSelection(QImage &editor) {
+  if (selection.isEmpty() && !selecting) {
+    return;
+  }
+  QRgb tint = qPremultiply(qRgba(80, 140, 255, 90));
+  QPainter overlay(&editor);
+  overlay.scale((qreal)editor.width() / imageSize,
+                (qreal)editor.height() / imageSize);
+  if (selection.isFloating()) {
+    QRect bounds = selection.floatingBounds();
+    overlay.drawImage(bounds, selection.floatingImage());
+    overlay.drawImage(bounds, selection.overlay(tint));
+  } else {
+    overlay.drawImage(0, 0, selection.overlay(tint));
+  }
+
+  if (selecting) {
+    QPen pen(Qt::white);
+    pen.setCosmetic(true);
+    pen.setStyle(Qt::DashLine);
+    overlay.setPen(pen);
+    overlay.setBrush(Qt::NoBrush);
+    if (currentTool == Tool::rectSelect) {
+      QPoint topLeft(std::min(selectStart.x(), selectEnd.x()),
+                     std::min(selectStart.y(), selectEnd.y()));
+      QPoint bottomRight(std::max(selectStart.x(), selectEnd.x()) + 1,
+                         std::max(selectStart.y(), selectEnd.y()) + 1);
+      overlay.drawRect(QRectF(topLeft, bottomRight));
+    } else {
+      // Run the path through the pixel centers.
+      overlay.translate(0.5, 0.5);
+      overlay.drawPolyline(lassoPath);
+    }
+  }
+}
+
+///
+/// \brief Model::mapToPixel - converts a position in the window to the pixel of
+/// the image under it. Positions outside the editor map outside the image.
+/// \param position The mouse position
+/// \return The pixel coordinates
+///
+QPoint Model::mapToPixel(QPointF position) {
+  float convertedMouseX = (position.x() - 410) / 480;
+  float convertedMouseY = (position.y() - 30) / 480;
+  return QPoint((int)std::floor(convertedMouseX * imageSize),
+                (int)std::floor(convertedMouseY * imageSize));
+}
+
+///
+/// \brief Model::layerColorTable
+/// \return The color table new layers are created with: the palette in an
+/// indexed project, otherwise empty for true color layers
+///
+QVector<QRgb> Model::layerColorTable() const {
+  return indexed ? palette.colorTable() : QVector<QRgb>();
+}
+
+///
+/// \brief Model::updateImageEditor - emits a signal to the view to update the
+/// image editing window visuals
+///
+void Model::updateImageEditor() {
+  if (currentPreviewFrame >= frames.size()) {
+    currentPreviewFrame = 0;
+  }
+  QImage editor = currentFrame->currentLayer->image.scaled(480, 480)
+                     .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  drawSelection(editor);
+  emit setImageEditor(editor);
+  QVector<Layer> layers;
+  for (const std::unique_ptr<Layer> &layer : currentFrame->layers) {
+    layers.append(*layer);
+  }
+  emit updateLayers(layers, currentFrame->currentLayerNum);
+  emit setPreviewImage(
+      frames[currentPreviewFrame]->getComposite().scaled(480, 480));
+}
+
+///
+/// \brief Model::mousePressed - this method captures mouse clicks and
+/// determines which model method needs to handle the click.
+/// \param event
+///
+void Model::mousePressed(QMouseEvent *event) {
+  QPointF mousePosition = event->position();
+  // while mouse clicks from editor window section
+  if (410 < mousePosition.rx() && mousePosition.rx() < 890 &&
+      30 < mousePosition.ry() && mousePosition.ry() < 510) {
+    draw = true;
+    editFramePixels(event);
+    return;
+  }
+  // while mouse clis from layer menu section
+  if (1020 < mousePosition.rx() && mousePosition.rx() < 1270 &&
+      370 < mousePosition.ry() && mousePosition.ry() < 620) {
+    emit changeSelectedLayer(event);
+  }
+}
+
+///
+/// \brief Model::setLayerSelect helper method used to set the layer
+/// \param index of the layer
+///
+void Model::setLayerSelect(int index) {
+  currentFrame->currentLayer = currentFrame->layers[index].get();
+  currentFrame->currentLayerNum = index;
+  updateImageEditor();
+}
+
+///
+/// \brief Model::mouseMove - captures the location of the mouse as it moves in
+/// the drawing window. Allows the user to click and draw to edit.
+/// \param event
+///
+void Model::mouseMove(QMouseEvent *event) {
+  // Keep following the mouse after it leaves the editor window so the stroke
+  // reaches the edge of the image; samples outside the image are clipped.
+  if (draw) {
+    editFramePixels(event);
+  }
+}
+
+///
+/// \brief Model::mouseReleased - sets draw to false so no more pixels will be
+/// edited as the mouse moves, and finishes the current stroke.
+/// \param event
+///
+void Model::mouseReleased(QMouseEvent *event) {
+  draw = false;
+  finishSelection();
+  applyStroke();
+  stroke.end();
+  history.endPixels();
+}
+
+///
+/// \brief Model::colorSelected updates the color
+/// \param color is the new color
+///
+void Model::colorSelected(const QColor &color) { currentColor = color; }
+
+///
+/// \brief Model::setOpacity - sets the opacity for the current color and tool
+/// to the new value.
+/// \param alpha
+///
+void Model::setOpacity(int alpha) { currentAlpha = alpha; }
+
+///
+/// \brief Model::setBrushSize - sets the diameter of the pen and eraser
+/// \param size in pixels
+///
+void Model::setBrushSize(int size) { brush.setSize(size); }
+
+///
+/// \brief Model::setBrushShape - sets the shape of the pen and eraser
+/// \param shape A Brush::Shape value
+///
+void Model::setBrushShape(int shape) {
+  brush.setShape(static_cast<Brush::Shape>(shape));
+}
+
+///
+/// \brief Model::setCustomBrush - sets the bitmap of the custom brush shape and
+/// selects it
+/// \param mask
+///
+void Model::setCustomBrush(const QImage &mask) {
+  brush.setCustomMask(mask);
+  brush.setShape(Brush::custom);
+}
+
+// ***LAYERS***
+
+///
+/// \brief Adds a blank layer
+///
+void Model::addBlankLayer() {
+  currentFrame->layers.push_back(
+      std::make_unique<Layer>(imageSize, layerColorTable()));
+  if (!indexStale) {
+    Layer *added = currentFrame->layers.back().get();
+    layersById.insert(added->id, added);
+  }
+  history.recordAddLayer(currentFrameNum - 1,
+                         (int)currentFrame->layers.size() - 1);
+  updateImageEditor();
+}
+
+///
+/// \brief Deletes the currently selected layer
+///
+void Model::deleteSelectedLayer() {
+  int pos = currentFrame->currentLayerNum;
+  LayerList &layers = currentFrame->layers;
+  if (layers.size() != 1 && pos >= 0 && pos < (int)layers.size()) {
+    std::unique_ptr<Layer> removed = std::move(layers[pos]);
+    layers.erase(layers.begin() + pos);
+    layersById.remove(removed->id);
+    history.recordRemoveLayer(currentFrameNum - 1, pos, std::move(removed));
+    currentFrame->currentLayerNum = 0;
+    currentFrame->currentLayer = layers[0].get();
+    emit setLayerSelect(0);
+  }
+  updateImageEditor();
+}
+
+///
+/// \brief Moves the selected layer up if possible
+///
+void Model::moveSelectedLayerUp() {
+  int pos = currentFrame->currentLayerNum;
+  if (pos > 0 && pos < (int)currentFrame->layers.size() - 1) {
+    moveItem(currentFrame->layers, pos, pos - 1);
+    currentFrame->currentLayerNum = pos - 1;
+    history.recordMoveLayer(currentFrameNum - 1, pos, pos - 1);
+  }
+  updateImageEditor();
+}
+
+///
+/// \brief Moves the currently selected layer down if possible
+///
+void Model::moveSelectedLayerDown() {
+  int pos = currentFrame->currentLayerNum;
+  if (pos >= 0 && pos < (int)currentFrame->layers.size() - 1) {
+    moveItem(currentFrame->layers, pos, pos + 1);
+    currentFrame->currentLayerNum = pos + 1;
+    history.recordMoveLayer(currentFrameNum - 1, pos, pos + 1);
+  }
+  updateImageEditor();
+}
+
+///
+/// \brief A slot used to set the name of the currently selected layer
+/// \param name The new name for the layer
+///
+void Model::RenameLayer(QString name) {
+  currentFrame->currentLayer->name = name;
+  emit updateLayerName(name);
+}
+///
+/// \brief Model::updateVisibility
+/// \param i: index of layer
+/// \param state: true(visible) or false(invisible)
+///
+void Model::updateVisibility(int i, bool state) {
+
+  if (i < (int)currentFrame->layers.size()) {
+    currentFrame->layers[i]->visible = state;
+    updateImageEditor();
+  }
+}
+
+//***FRAMES***:
+
+///
+/// \brief a slot that insert a new frame in frames collection(Model)
+///
+void Model::addNewFrameClicked() {
+  frames.push_back(std::make_unique<Frame>(imageSize, layerColorTable()));
+  indexLayers(*frames.back(), true);
+  updatePositions(frames.size() - 1, frames.size());
+  history.recordAddFrame(frames.size() - 1);
+  // edge case: when there is no frame before adding the new frame
+  if (frames.size() == 1) {
+    // update current frame
+    currentFrame = frames[0].get();
+  }
+
+  emit addANewFrameOnUi();
+}
+///
+/// \brief a slot that removing the selected frame from frames collection(Model)
+///
+void Model::removeFrameClicked() {
+  if (currentFrameNum - 1 == 0 && frames.size() == 1) {
+    emit giveWarningMessage(); // Message to not delete frame warning box
+    return;
+  }
+  // The history keeps the removed frame so the removal can be undone.
+  Frame &removed = *frames[currentFrameNum - 1];
+  indexLayers(removed, false);
+  framePositions.remove(removed.id);
+  history.recordRemoveFrame(currentFrameNum - 1,
+                            std::move(frames[currentFrameNum - 1]));
+  frames.erase(frames.begin() + (currentFrameNum - 1));
+  updatePositions(currentFrameNum - 1, frames.size());
+
+  if ((ulong)currentFrameNum >
+      frames.size()) { // if we remove the end one, we don't want to overflow.
+    currentFrameNum = frames.size();
+  }
+  if (currentFrameNum - 1 > 0 &&
+      (ulong)currentFrameNum - 1 <
+          frames.size()) { // if we remove the frame within the bound,update
+                           // current frame.
+    currentFrame = frames[currentFrameNum - 1].get();
+  }
+  if (currentFrameNum - 1 == 0 &&
+      frames.size() != 0) { // if we remove the first frame
+    currentFrame = frames[currentFrameNum - 1].get();
+  }
+
+  emit removeFrameOnUi();
+  emit setFrameHighlight(currentFrameNum);
+  updateImageEditor();
+}
+
+void Model::copyFrameClicked() {
+  frames.push_back(std::make_unique<Frame>(*currentFrame));
+  indexLayers(*frames.back(), true);
+  updatePositions(frames.size() - 1, frames.size());
+  history.recordAddFrame(frames.size() - 1);
+
+  emit addANewFrameOnUi();
+}
+
+///
+/// \brief Model::moveFrameLeftClicked swaps the current frame with the one
+/// before it
+///
+void Model::moveFrameLeftClicked() {
+  int index = currentFrameNum - 1;
+  if (index <= 0) {
+    return;
+  }
+  std::swap(frames[index], frames[index - 1]);
+  updatePositions(index - 1, index + 1);
+  history.recordMoveFrame(index, index - 1);
+  showEdit(index - 1, currentFrame->currentLayerNum);
+}
+
+///
+/// \brief Model::moveFrameRightClicked swaps the current frame with the one
+/// after it
+///
+void Model::moveFrameRightClicked() {
+  int index = currentFrameNum - 1;
+  if (index + 1 >= (int)frames.size()) {
+    return;
+  }
+  std::swap(frames[index], frames[index + 1]);
+  updatePositions(index, index + 2);
+  history.recordMoveFrame(index, index + 1);
+  showEdit(index + 1, currentFrame->currentLayerNum);
+}
+
+//***UNDO/REDO***:
+
+///
+/// \brief Model::undo reverts the most recent edit
+///
+void Model::undo() {
+  // Edits can't be reverted halfway through a stroke.
+  if (draw) {
+    return;
+  }
+  int frameIndex;
+  int layerIndex;
+  if (history.undo(frames, frameIndex, layerIndex)) {
+    indexStale = true;
+    // Restored layers may predate a palette edit.
+    if (indexed) {
+      applyPalette();
+    }
+    showEdit(frameIndex, layerIndex);
+  }
+}
+
+///
+/// \brief Model::redo re-applies the most recently undone edit
+///
+void Model::redo() {
+  if (draw) {
+    return;
+  }
+  int frameIndex;
+  int layerIndex;
+  if (history.redo(frames, frameIndex, layerIndex)) {
+    indexStale = true;
+    if (indexed) {
+      applyPalette();
+    }
+    showEdit(frameIndex, layerIndex);
+  }
+}
+
+///
+/// \brief Model::clearHistory forgets every edit, so none can be undone
+///
+void Model::clearHistory() { history.clear(); }
+
+///
+/// \brief Model::showEdit selects the frame and layer an edit affected and
+/// refreshes the whole UI, since the edit may have changed the frame list
+/// \param frameIndex
+/// \param layerIndex
+///
+void Model::showEdit(int frameIndex, int layerIndex) {
+  frameIndex = std::clamp(frameIndex, 0, (int)frames.size() - 1);
+  currentFrameNum = frameIndex + 1;
+  currentFrame = frames[frameIndex].get();
+  layerIndex = std::clamp(layerIndex, 0, (int)currentFrame->layers.size() - 1);
+  currentFrame->currentLayerNum = layerIndex;
+  currentFrame->currentLayer = currentFrame->layers[layerIndex].get();
+
+  emit framesChanged();
+  emit setFrameHighlight(currentFrameNum);
+  updateImageEditor();
+}
+
+///
+/// \brief Model::frameById finds a frame by id, whatever its current position
+/// \param id A Frame::id
+/// \return The frame, or nullptr if it isn't in the project
+///
+Frame *Model::frameById(int id) {
+  int index = indexOfFrame(id);
+  return index < 0 ? nullptr : frames[index].get();
+}
+
+///
+/// \brief Model::indexOfFrame
+/// \param id A Frame::id
+/// \return The position of the frame in frames, or -1 if it isn't there
+///
+int Model::indexOfFrame(int id) {
+  reindex();
+  return framePositions.value(id, -1);
+}
+
+///
+/// \brief Model::layerById finds a layer by id in any frame
+/// \param id A Layer::id
+/// \return The layer, or nullptr if it isn't in the project
+///
+Layer *Model::layerById(int id) {
+  reindex();
+  return layersById.value(id, nullptr);
+}
+
+///
+/// \brief Model::lookupRebuilds
+/// \return How many times the id lookups were built from scratch, which
+/// frame and layer edits made through the model never cause
+///
+int Model::lookupRebuilds() const { return rebuilds; }
+
+///
+/// \brief Model::reindex rebuilds the id lookups if they are stale. Frame and
+/// layer edits made here keep the lookups up to date as they go; only undo,
+/// redo, loading and resizing, which change frames out of the model's sight,
+/// mark them stale, and a run of those costs one rebuild at the next lookup.
+///
+void Model::reindex() {
+  if (!indexStale) {
+    return;
+  }
+  framePositions.clear();
+  layersById.clear();
+  for (int i = 0; i < (int)frames.size(); i++) {
+    framePositions.insert(frames[i]->id, i);
+    indexLayers(*frames[i], true);
+  }
+  indexStale = false;
+  rebuilds++;
+}
+
+///
+/// \brief Model::updatePositions records the positions of frames that were
+/// inserted or shifted. Only the range that moved is visited, so adding a
+/// frame at the end or swapping two costs O(1), and removing one costs as
+/// much as the erase from frames itself.
+/// \param from The first index to record
+/// \param to One past the last index to record
+///
+void Model::updatePositions(int from, int to) {
+  if (indexStale) {
+    return;
+  }
+  for (int i = from; i < to; i++) {
+    framePositions.insert(frames[i]->id, i);
+  }
+}
+
+///
+/// \brief Model::indexLayers adds the layers of a frame to the layer lookup,
+/// or removes them. Layers are found by address, so frame positions don't
+/// matter.
+/// \param frame A frame entering or leaving the project
+/// \param add true if the frame is entering
+///
+void Model::indexLayers(const Frame &frame, bool add) {
+  for (const std::unique_ptr<Layer> &layer : frame.layers) {
+    if (add) {
+      layersById.insert(layer->id, layer.get());
+    } else {
+      layersById.remove(layer->id);
+    }
+  }
+}
+
+//***SELECTION***:
+
+///
+/// \brief Model::selectAll selects the whole canvas
+///
+void Model::selectAll() {
+  selection.selectAll();
+  updateImageEditor();
+}
+
+///
+/// \brief Model::deselect clears the selection
+///
+void Model::deselect() {
+  selection.clear();
+  updateImageEditor();
+}
+
+///
+/// \brief Model::invertSelection selects every pixel that is not selected and
+/// deselects the rest
+///
+void Model::invertSelection() {
+  selection.invert();
+  updateImageEditor();
+}
+
+///
+/// \brief Model::flipSelectionHorizontal mirrors the selected pixels left to
+/// right
+///
+void Model::flipSelectionHorizontal() {
+  transformSelection(Selection::flipHorizontal);
+}
+
+///
+/// \brief Model::flipSelectionVertical mirrors the selected pixels top to
+/// bottom
+///
+void Model::flipSelectionVertical() {
+  transformSelection(Selection::flipVertical);
+}
+
+///
+/// \brief Model::rotateSelection turns the selected pixels 90 degrees
+/// clockwise
+///
+void Model::rotateSelection() {
+  transformSelection(Selection::rotateClockwise);
+}
+
+//***PALETTE***:
+
+///
+/// \brief Model::isIndexed
+/// \return true if the layers store palette indices
+///
+bool Model::isIndexed() const { return indexed; }
+
+///
+/// \brief Model::getPalette
+/// \return The project palette; it only holds the transparent color unless
+/// the project is indexed
+///
+const Palette &Model::getPalette() const { return palette; }
+
+///
+/// \brief Model::convertToIndexed switches the project to indexed color. The
+/// palette is built from the colors the layers already use, so nothing is
+/// quantized. The history is cleared since its pixels are in the old format.
+/// \return false, leaving the project unchanged, if the layers use more colors
+/// than the palette can hold
+///
+bool Model::convertToIndexed() {
+  if (indexed) {
+    return true;
+  }
+  if (draw) {
+    return false;
+  }
+
+  // Collect the colors first so a failed conversion changes nothing.
+  palette.clear();
+  for (const std::unique_ptr<Frame> &frame : frames) {
+    for (const std::unique_ptr<Layer> &layer : frame->layers) {
+      QImage image =
+          layer->image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+      for (int y = 0; y < image.height(); y++) {
+        const QRgb *pixels =
+            reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); x++) {
+          QRgb color = qUnpremultiply(pixels[x]);
+          if (palette.indexOf(color) >= 0) {
+            continue;
+          }
+          if (palette.isFull()) {
+            palette.clear();
+            return false;
+          }
+          palette.add(color);
+        }
+      }
+    }
+  }
+
+  for (const std::unique_ptr<Frame> &frame : frames) {
+    for (const std::unique_ptr<Layer> &layer : frame->layers) {
+      layer->image = indexedImage(layer->image);
+    }
+  }
+  indexed = true;
+  history.clear();
+  updateImageEditor();
+  return true;
+}
+
+///
+/// \brief Model::convertToTrueColor switches the project back to 32-bit layers
+/// and clears the history
+///
+void Model::convertToTrueColor() {
+  if (!indexed || draw) {
+    return;
+  }
+  for (const std::unique_ptr<Frame> &frame : frames) {
+    for (const std::unique_ptr<Layer> &layer : frame->layers) {
+      layer->image =
+          layer->image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+  }
+  indexed = false;
+  palette.clear();
+  history.clear();
+  updateImageEditor();
+}
+
+///
+/// \brief Model::setPaletteColor changes one palette color. Only the color
+/// tables change, so every pixel using the index is recolored without touching
+/// the pixel data.
+/// \param index The palette index, 0 (transparent) can't be changed
+/// \param color The new color
+///
+void Model::setPaletteColor(int index, const QColor &color) {
+  if (!indexed) {
+    return;
+  }
+  palette.setColor(index, qRgba(color.red(), color.green(), color.blue(),
+                                color.alpha()));
+  applyPalette();
+  emit framesChanged();
+  updateImageEditor();
+}
+
+///
+/// \brief Model::paletteIndex finds the current color in the palette, adding
+/// it if it is new. The color is rounded through premultiplied alpha first,
+/// like the pixels convertToIndexed reads, so a translucent color painted
+/// before the conversion is found again instead of being added twice.
+/// \return The palette index to paint with
+///
+int Model::paletteIndex() {
+  int size = palette.size();
+  QRgb color = qPremultiply(qRgba(currentColor.red(), currentColor.green(),
+                                  currentColor.blue(), currentAlpha));
+  int index = palette.add(qUnpremultiply(color));
+  if (palette.size() != size) {
+    applyPalette();
+  }
+  return index;
+}
+
+///
+/// \brief Model::applyPalette gives every layer the current palette as its
+/// color table. This is O(palette size) per layer; the pixels are untouched.
+///
+void Model::applyPalette() {
+  for (const std::unique_ptr<Frame> &frame : frames) {
+    for (const std::unique_ptr<Layer> &layer : frame->layers) {
+      layer->image.setColorTable(palette.colorTable());
+    }
+  }
+}
+
+///
+/// \brief Model::indexedImage converts a layer image to palette indices.
+/// Colors missing from the palette are added, or mapped to the nearest color
+/// once it is full.
+/// \param image A layer image
+/// \return An indexed image using the palette
+///
+QImage Model::indexedImage(const QImage &image) {
+  QImage source = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  QImage result(source.size(), QImage::Format_Indexed8);
+  QRgb lastColor = 0;
+  int lastIndex = Palette::transparent;
+  for (int y = 0; y < source.height(); y++) {
+    const QRgb *pixels =
+        reinterpret_cast<const QRgb *>(source.constScanLine(y));
+    uchar *indices = result.scanLine(y);
+    for (int x = 0; x < source.width(); x++) {
+      // Neighbouring pixels are usually the same color.
+      if (pixels[x] != lastColor) {
+        lastColor = pixels[x];
+        lastIndex = palette.add(qUnpremultiply(lastColor));
+      }
+      indices[x] = lastIndex;
+    }
+  }
+  result.setColorTable(palette.colorTable());
+  return result;
+}
+
+///
+/// \brief Model::handleLeftScroll is a private helper for when when the left
+/// button scrolls
+///
+void Model::handleLeftScroll() {
+  if (currentFrameNum == 1) { // when current frame is the first frame, click
+                              // the left scrooll should return the last frame
+    currentFrameNum = frames.size();
+  } else {
+    currentFrameNum--;
+  }
+  currentFrame = frames[currentFrameNum - 1].get();
+}
+
+///
+/// \brief Model::handleRightScroll is a private helper for when when the right
+/// button scrolls
+///
+void Model::handleRightScroll() {
+  if (currentFrameNum >=
+      (int)frames.size()) { // when current frame is the last frame, click the
+                            // right scrooll should return the first frame
+    currentFrameNum = 1;
+  } else {
+    currentFrameNum++;
+  }
+
+  currentFrame = frames[currentFrameNum - 1].get();
+}
+
+///
+/// \brief Model::leftScrollButtonClicked handles when the button to the left of
+/// the frame view is clicked
+///
+void Model::leftScrollButtonClicked() {
+  handleLeftScroll();
+  emit setFrameHighlight(currentFrameNum);
+  updateImageEditor();
+}
+
+///
+/// \brief Model::rightScrollButtonClicked handles when the button to the right
+/// of the frame view is clicked
+///
+void Model::rightScrollButtonClicked() {
+  handleRightScroll();
+  emit setFrameHighlight(currentFrameNum);
+  updateImageEditor();
+}
+
+//***PREVIEW STUFF***:
+
+///
+/// \brief Model::receiveFrameRate updates the framerate internally
+/// \param newFrameRate is the new framerate
+///
+void Model::receiveFrameRate(int newFrameRate) { frameRate = newFrameRate; }
+
+///
+/// \brief Recursive looping method to write the frames to the preview
+///  Is called once in constructor to get started; afterwards it calls itself at
+///  the proper timing.
+void Model::displayNextPreviewFrame() {
+  // Basically, recursively calls every 1000/(frameRate) ms.
+  QTimer::singleShot(1000 / frameRate, this, &Model::displayNextPreviewFrame);
+
+  if (currentPreviewFrame >= frames.size() - 1) {
+    // Will need to "reset" loop
+    currentPreviewFrame = 0;
+
+  } else {
+    currentPreviewFrame++;
+  }
+
+  emit setPreviewImage(
+      frames[currentPreviewFrame]->getComposite().scaled(480, 480));
+}
+
+//***SAVING/LOADING PROJECT***:
+
+///
+/// \brief Model::write writes the project to a JSON file
+/// \param json is the JSON object
+///
+void Model::write(QJsonObject &json) {
+  // write height, width, number of frames variables to JSON
+  json["height"] = height;
+  json["width"] = width;
+  numOfFrames = frames.size();
+  json["numberOfFrames"] = numOfFrames;
+  json["indexed"] = indexed;
+  if (indexed) {
+    json["palette"] = palette.write();
+  }
+
+  // write all the frames to JSON
+  QJsonArray frameArray;
+
+  for (const std::unique_ptr<Frame> &frame : frames) {
+    QJsonObject frameObject;
+    frame->write(frameObject);
+    frameArray.append(frameObject);
+  }
+  json["frames"] = frameArray;
+}
+
+///
+/// \brief Model::read reads the JSON from a saved project
+/// \param json the JSON object being read
+///
+void Model::read(QJsonObject &json) {
+  // Verify height and width equal
+  if (json.contains("height") && json["height"].isDouble()) {
+    height = json["height"].toInt();
+  }
+  if (json.contains("width") && json["width"].isDouble()) {
+    width = json["width"].toInt();
+  }
+  if (height != width) {
+    qWarning("File does not have square format (height != width)");
+  }
+
+  imageSize = height;
+  selection.resize(imageSize, imageSize);
+  // Check number of frames
+  if (json.contains("numberOfFrames") && json["numberOfFrames"].isDouble()) {
+    numOfFrames = json["numberOfFrames"].toInt();
+  }
+
+  // read all the frames
+  if (json.contains("frames") && json["frames"].isArray()) {
+    QJsonArray frameArray = json["frames"].toArray();
+    frames.clear();
+    indexStale = true;
+    history.clear();
+    ImagePool::clear();
+    for (QJsonValue v : frameArray) {
+      QJsonObject frameObject = v.toObject();
+      frames.push_back(std::make_unique<Frame>(imageSize));
+      currentFrame = frames.back().get();
+      currentFrame->read(frameObject);
+    }
+  }
+
+  // Frames are saved as colors; map them back onto the saved palette.
+  indexed = json.contains("indexed") && json["indexed"].toBool() &&
+            json.contains("palette") && json["palette"].isArray();
+  palette.clear();
+  if (indexed) {
+    palette.read(json["palette"].toArray());
+    for (const std::unique_ptr<Frame> &frame : frames) {
+      for (const std::unique_ptr<Layer> &layer : frame->layers) {
+        layer->image = indexedImage(layer->image);
+      }
+    }
+    applyPalette();
+  }
+}
+
+///
+/// \brief Model::setSize sets the size internally and updates the appropriate
+/// elements
+/// \param size of the new project
+///
+void Model::setSize(int size) {
+  // update sizes where needed
+  imageSize = size;
+  height = imageSize;
+  width = imageSize;
+  // clear any old frames, and the buffers pooled for their size
+  frames.clear();
+  indexStale = true;
+  history.clear();
+  ImagePool::clear();
+  selection.resize(imageSize, imageSize);
+  indexed = false;
+  palette.clear();
+  frames.push_back(std::make_unique<Frame>(imageSize));
+  currentFrame = frames[0].get();
+  // deafult the color
+  currentColor = QColor{255, 255, 255, 0};
+  currentFrameNum = 1;
+  currentPreviewFrame = 0;
+  addFrameIndex = 1;
+  // update the ui
+  displayNextPreviewFrame();
+  emit setFrameHighlight(1);
+  updateImageEditor();
+}
+
+///
+/// \brief Saves the project to the directory
+/// \param fileName to save the file to
+///
+void Model::saveProject(QString fileName) {
+  // create and open the save file
+  QFile saveFile(fileName);
+  if (!saveFile.open(QIODevice::WriteOnly)) {
+    qWarning("Couldn't open save file.");
+  }
+  QJsonObject gameObject;
+  // write the project to JSON
+  write(gameObject);
+  // save the project to the file
+  saveFile.write(QJsonDocument(gameObject).toJson());
+}
+
+///
+/// \brief Model::loadProject loads a project of the given fileName
+/// \param fileName
+///
+void Model::loadProject(QString fileName) {
+  QFile loadFile(fileName);
+  if (!loadFile.open(QIODevice::ReadOnly)) {
+    qWarning("Couldn't open save file.");
+  }
+  // create the JSON object to be read
+  QByteArray saveData = loadFile.readAll();
+  QJsonDocument loadDoc(QJsonDocument::fromJson(saveData));
+  QJsonObject obj = loadDoc.object();
+
+  read(obj);
+  // update the ui based on the loaded project
+  updateImageEditor();
+}
+
+///
+/// \brief Model::importGIF replaces the project with the frames of a gif, each
+/// as a frame with one layer. Projects are square, so a gif that isn't is
+/// placed in the top left corner of the frames.
+/// \param fileName The gif to read
+/// \return false if it couldn't be read or has no frames; the project is
+/// left alone then
+///
+bool Model::importGIF(QString fileName) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qWarning("Couldn't open gif file.");
+    return false;
+  }
+  GifReader reader(&file);
+  if (!reader.begin()) {
+    return false;
+  }
+
+  int size = std::max(reader.size().width(), reader.size().height());
+  FrameList imported;
+  QImage canvas;
+  while (reader.readFrame(canvas)) {
+    imported.push_back(std::make_unique<Frame>(size));
+    QPainter framePainter(&imported.back()->layers[0]->image);
+    framePainter.drawImage(0, 0, canvas);
+  }
+  // A damaged file keeps the frames decoded before the damage.
+  if (imported.empty()) {
+    return false;
+  }
+  replaceFrames(std::move(imported), size);
+  return true;
+}
+
+///
+/// \brief Model::importImages replaces the project with imported images, each
+/// as a frame with one layer. Identical images share their pixels until one
+/// of them is edited.
+/// \param images Frames read by Import
+/// \return false if there are none; the project is left alone then
+///
+bool Model::importImages(const QVector<QImage> &images) {
+  if (images.isEmpty()) {
+    return false;
+  }
+  int size = 0;
+  for (const QImage &image : images) {
+    size = std::max({size, image.width(), image.height()});
+  }
+  FrameList imported;
+  for (const QImage &image : Import::toFrames(images, size)) {
+    imported.push_back(std::make_unique<Frame>(size));
+    imported.back()->layers[0]->image = image;
+  }
+  replaceFrames(std::move(imported), size);
+  return true;
+}
+
+///
+/// \brief Model::replaceFrames makes imported frames the project, as loading a
+/// project does
+/// \param imported The new frames
+/// \param size Their side
+///
+void Model::replaceFrames(FrameList imported, int size) {
+  imageSize = size;
+  height = size;
+  width = size;
+  selection.resize(imageSize, imageSize);
+  frames = std::move(imported);
+  indexStale = true;
+  history.clear();
+  ImagePool::clear();
+  indexed = false;
+  palette.clear();
+  currentPreviewFrame = 0;
+  showEdit(0, 0);
+}
+
+///
+/// \brief Model::memoryReport measures the memory held by the project: its
+/// layers, the undo history, pooled buffers and the lifted selection
+/// \param findDuplicates Also look for layers with identical but unshared
+/// pixels, which reads every pixel; without it only the layers are walked
+/// \return The report; its display bytes are left for the view to add
+///
+MemoryReport Model::memoryReport(bool findDuplicates) {
+  MemoryReport report = MemoryReport::measure(frames, findDuplicates);
+  report.historyBytes = history.memoryUsage();
+  report.selectionBytes = selection.floatingImage().sizeInBytes();
+  return report;
+}
+
+//***EXPORTING***:
+///
+/// \brief Model::composites
+/// \return The composite of every frame, in order
+///
+QVector<QImage> Model::composites() {
+  QVector<QImage> images;
+  images.reserve(frames.size());
+  for (const std::unique_ptr<Frame> &f : frames) {
+    images.append(f->getComposite());
+  }
+  return images;
+}
+
+///
+/// \brief Model::readComposites reads a saved project without loading it
+/// \param fileName The project file
+/// \return The composite of every frame in it, empty if it couldn't be read
+///
+QVector<QImage> Model::readComposites(QString fileName) {
+  QVector<QImage> images;
+  QFile loadFile(fileName);
+  if (!loadFile.open(QIODevice::ReadOnly)) {
+    qWarning("Couldn't open save file.");
+    return images;
+  }
+  QJsonObject obj = QJsonDocument::fromJson(loadFile.readAll()).object();
+  int size = obj["height"].toInt();
+  for (QJsonValue v : obj["frames"].toArray()) {
+    QJsonObject frameObject = v.toObject();
+    Frame frame(size);
+    frame.read(frameObject);
+    images.append(frame.getComposite());
+  }
+  return images;
+}
+
+///
+/// \brief Model::saveGIF saves all of the frames into a gif using the framerate
+/// in the viewer
+/// \param fileName The file to save to
+/// \param parallel Encode the frames on the thread pool; the file is the same
+/// either way
+/// \return false if it couldn't be written
+///
+bool Model::saveGIF(QString fileName, bool parallel) {
+  return Export::saveGIF(composites(), frameRate, fileName, 1,
+                         Export::NoDither, parallel);
+}
+
+///
+/// \brief Model::savePNG saves the selected frame to a file
+/// \param fileName The Filename to save to
+///
+void Model::savePNG(QString fileName) {
+  Export::savePNG(currentFrame->getComposite(), fileName + ".png");
+}
+
+///
+/// \brief Model::exportGIF queues a gif of the frames as they are now. Editing
+/// can go on while it is written.
+/// \param fileName The file to save to
+/// \param scale Integer upscaling factor
+/// \param dither How frames with more than 255 colors are quantized
+/// \return The export job
+///
+int Model::exportGIF(QString fileName, int scale, Export::Dither dither) {
+  return exports.submitGIF(composites(), frameRate, fileName, scale, dither);
+}
+
+///
+/// \brief Model::exportAPNG queues an animated png of the frames as they are
+/// now, which keeps partial transparency that a gif would lose
+/// \param fileName The file to save to
+/// \param scale Integer upscaling factor
+/// \return The export job
+///
+int Model::exportAPNG(QString fileName, int scale) {
+  if (!fileName.endsWith(".png", Qt::CaseInsensitive)) {
+    fileName += ".png";
+  }
+  return exports.submitAPNG(composites(), frameRate, fileName, scale);
+}
+
+///
+/// \brief Model::exportPNG queues a png of the selected frame as it is now
+/// \param fileName The Filename to save to
+/// \param scale Integer upscaling factor
+/// \return The export job
+///
+int Model::exportPNG(QString fileName, int scale) {
+  return exports.submitPNG(currentFrame->getComposite(), fileName + ".png",
+                           scale);
+}
+
+///
+/// \brief Model::exportPNGSequence queues a png of every frame as it is now,
+/// named name_001.png, name_002.png, ... The files are compressed in parallel.
+/// \param fileName The sequence's path; a .png extension is dropped
+/// \param scale Integer upscaling factor
+/// \param layers Write every layer of every frame on its own instead, as
+/// name_001_layer1.png, name_001_layer2.png, ...
+/// \param level zlib compression level, or -1 for the default
+/// \param palette Write frames with at most 256 colors as palette pngs
+/// \return The export job
+///
+int Model::exportPNGSequence(QString fileName, int scale, bool layers,
+                             int level, bool palette) {
+  if (fileName.endsWith(".png", Qt::CaseInsensitive)) {
+    fileName.chop(4);
+  }
+  QVector<QImage> images;
+  QStringList fileNames;
+  int count = frames.size();
+  for (int i = 0; i < count; i++) {
+    QString name = Export::sequenceName(fileName, i, count);
+    if (!layers) {
+      images.append(frames[i]->getComposite());
+      fileNames.append(name + ".png");
+      continue;
+    }
+    const LayerList &frameLayers = frames[i]->layers;
+    for (int j = 0; j < (int)frameLayers.size(); j++) {
+      images.append(frameLayers[j]->image);
+      fileNames.append(name + QString("_layer%1.png").arg(j + 1));
+    }
+  }
+  return exports.submitPNGSequence(images, fileNames, scale, level, palette);
+}
+
+///
+/// \brief Model::exportAtlas queues a sprite sheet of the frames as they are
+/// now, together with the frames of other saved projects. Frames are named
+/// frame_1, frame_2, ... and those of other projects are prefixed with the
+/// project's name, as in walk/frame_1.
+/// \param fileName The png to write, the json goes next to it
+/// \param otherProjects Saved projects to add to the sheet
+/// \return The export job
+///
+int Model::exportAtlas(QString fileName, QStringList otherProjects) {
+  QVector<Atlas::Sprite> sprites;
+  QVector<QImage> images = composites();
+  for (int i = 0; i < images.size(); i++) {
+    sprites.append(Atlas::Sprite{QString("frame_%1").arg(i + 1), images[i]});
+  }
+  for (const QString &project : otherProjects) {
+    QString prefix = QFileInfo(project).completeBaseName() + "/";
+    images = readComposites(project);
+    for (int i = 0; i < images.size(); i++) {
+      sprites.append(
+          Atlas::Sprite{prefix + QString("frame_%1").arg(i + 1), images[i]});
+    }
+  }
+  if (!fileName.endsWith(".png", Qt::CaseInsensitive)) {
+    fileName += ".png";
+  }
+  return exports.submitAtlas(sprites, fileName);
+}
@@ -0,0 +1,207 @@
+#ifndef MODEL_H
+#define MODEL_H
+
+#include "Brush.h"
+#include "Export.h"
+#include "Frame.h"
+#include "History.h"
+#include "MemoryReport.h"
+#include "Palette.h"
+#include "QPainter"
+#include "Selection.h"
+#include "Stroke.h"
+#include <QDir>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QObject>
+#include <QTimer>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+class Model : public QObject {
+  Q_OBJECT
+public:
+  explicit Model(QObject *parent = nullptr);
+
+  int currentFrameNum;
+
+  // Frame Stuff
+  Frame *currentFrame; // owned by frames
+  FrameList frames;
+  unsigned int currentPreviewFrame;
+  int addFrameIndex;
+  Frame *frameById(int id);
+  int indexOfFrame(int id);
+  Layer *layerById(int id);
+  int lookupRebuilds() const;
+  bool draw;
+
+  // Saving methods
+  void read(QJsonObject &json);
+  void write(QJsonObject &json);
+  void setSize(int size);
+  void saveProject(QString fileName);
+  void loadProject(QString fileName);
+  bool importGIF(QString fileName);
+  bool importImages(const QVector<QImage> &images);
+  void savePNG(QString fileName);
+  bool saveGIF(QString fileName, bool parallel = true);
+  int exportPNG(QString fileName, int scale = 1);
+  int exportAPNG(QString fileName, int scale = 1);
+  int exportPNGSequence(QString fileName, int scale = 1, bool layers = false,
+                        int level = -1, bool palette = false);
+  int exportGIF(QString fileName, int scale = 1,
+                Export::Dither dither = Export::NoDither);
+  int exportAtlas(QString fileName, QStringList otherProjects);
+  QVector<QImage> composites();
+  static QVector<QImage> readComposites(QString fileName);
+  ExportQueue exports; // background exports, see exportPNG and exportGIF
+  MemoryReport memoryReport(bool findDuplicates = false);
+
+  void clearHistory();
+
+  // Palette methods
+  bool isIndexed() const;
+  const Palette &getPalette() const;
+  bool convertToIndexed();
+  void convertToTrueColor();
+  void setPaletteColor(int index, const QColor &color);
+
+public slots:
+  // Toolbox slots
+  void cursorButtonClicked();
+  void penButtonClicked();
+  void eraserButtonClicked();
+  void bucketButtonClicked();
+  void rectSelectClicked();
+  void lassoSelectClicked();
+  void magicWandClicked();
+
+  // Color change slots
+  void colorSelected(const QColor &color);
+  void setOpacity(int);
+
+  // Brush slots
+  void setBrushSize(int size);
+  void setBrushShape(int shape);
+  void setCustomBrush(const QImage &mask);
+
+  // Tool Bar slots
+  void addBlankLayer();
+  void RenameLayer(QString name);
+  void deleteSelectedLayer();
+  void moveSelectedLayerUp();
+  void moveSelectedLayerDown();
+  void addNewFrameClicked();
+  void removeFrameClicked();
+  void copyFrameClicked();
+  void moveFrameLeftClicked();
+  void moveFrameRightClicked();
+
+  // Edit slots
+  void undo();
+  void redo();
+
+  // Selection slots
+  void selectAll();
+  void deselect();
+  void invertSelection();
+  void flipSelectionHorizontal();
+  void flipSelectionVertical();
+  void rotateSelection();
+
+  // Frame selector slots
+  void leftScrollButtonClicked();
+  void rightScrollButtonClicked();
+  void receiveFrameRate(int);
+
+  // Frame Editor slots
+  void mousePressed(QMouseEvent *);
+  void mouseMove(QMouseEvent *);
+  void mouseReleased(QMouseEvent *);
+
+  // Layer Slots
+  void updateVisibility(int, bool);
+  void setLayerSelect(int);
+
+signals:
+  void giveWarningMessage();
+  void setCursorButton(QString);
+  void setPenButton(QString);
+  void setEraserButton(QString);
+  void setBucketButton(QString);
+  void drawTheFrameInSpriteEditorPanel();
+  void setFrameHighlight(int idx);
+  void addANewFrameOnUi();
+  void removeFrameOnUi();
+  void framesChanged();
+  void setPreviewImage(QImage);
+  void setImageEditor(QImage);
+  void newLayer();
+  void updateLayerName(QString name);
+  void updateLayers(QVector<Layer>, int);
+  void changeSelectedLayer(QMouseEvent *event);
+
+private:
+  void resetToolButtons();
+  void displayNextPreviewFrame();
+  void handleLeftScroll();
+  void handleRightScroll();
+  void resetAllHighlightedFrame();
+  void setFrameHighlighted(int);
+  void editFramePixels(QMouseEvent *event);
+  void applyStroke();
+  void editSelection(QMouseEvent *event);
+  void moveSelection(QMouseEvent *event);
+  void finishSelection();
+  void transformSelection(Selection::Transform transform);
+  void drawSelection(QImage &editor);
+  QPoint mapToPixel(QPointF position);
+  void reindex();
+  void updatePositions(int from, int to);
+  void indexLayers(const Frame &frame, bool add);
+  QVector<QRgb> layerColorTable() const;
+  int paletteIndex();
+  void applyPalette();
+  QImage indexedImage(const QImage &image);
+  void updateImageEditor();
+  void replaceFrames(FrameList imported, int size);
+  void showEdit(int frameIndex, int layerIndex);
+
+  // Tool enum for the toolbox.
+  enum Tool { cursor, pen, eraser, bucket, rectSelect, lassoSelect, magicWand };
+  Tool currentTool;
+  History history;
+  Brush brush;
+  Stroke stroke;
+  QTimer strokeTimer; // coalesces queued mouse moves into one stroke batch
+  Selection selection;
+  Selection::Mode selectionMode;
+  bool selecting;     // a rectangle or lasso is being dragged out
+  QPoint selectStart; // pixel where the drag started
+  QPoint selectEnd;   // pixel under the mouse
+  QPolygon lassoPath;
+  QPoint floatingStart; // position of the floating pixels when lifted
+  Palette palette;
+  bool indexed; // layers store palette indices instead of colors
+  QHash<int, int> framePositions; // frame id to its index in frames
+  QHash<int, Layer *> layersById;
+  bool indexStale; // frames or layers changed out of sight, e.g. by undo
+  int rebuilds;    // times the lookups were built from scratch
+  QPainter painter;
+  QColor currentColor;
+  int currentAlpha; // opacity
+  int imageSize;
+  int height;
+  int width;
+  int numOfFrames;
+  int frameRate; // For preview
+};
+
+#endif // MODEL_H
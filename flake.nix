@@ -38,6 +38,7 @@
 
             buildInputs = [
               pkgs.qt6.qtbase
+              pkgs.zlib
             ];
 
             buildPhase = ''
@@ -47,7 +48,7 @@
 
             installPhase = ''
               mkdir -p $out/bin
-              install -m755 "Sprite_Editor" $out/bin/sprite-editor
+              install -m755 "app/Sprite_Editor" $out/bin/sprite-editor
             '';
           };
         }
@@ -0,0 +1,373 @@
+#include "Export.h"
+#include "GifReader.h"
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+///
+/// \brief The GifTests class checks the gif encoder and GifReader against
+/// each other: exported animations must decode to their frames and delays,
+/// the parallel export must write the same bytes as the serial one, a held
+/// frame must keep its whole duration, and images that overflow the lzw
+/// dictionary many times must decode to themselves. Damaged or oversized
+/// files must be refused before anything is decoded.
+///
+class GifTests : public QObject {
+  Q_OBJECT
+
+private slots:
+  void roundTrip_data();
+  void roundTrip();
+  void truncated();
+  void oversizedScreen();
+  void descriptor_data();
+  void descriptor();
+  void serialMatchesParallel_data();
+  void serialMatchesParallel();
+  void longHold();
+  void noisyRoundTrip_data();
+  void noisyRoundTrip();
+
+private:
+  // A gradient has thousands of colors, so every frame is quantized; a sprite
+  // has a few, mapped exactly; mixed alternates the two.
+  enum Colors { gradient, sprite, mixed };
+
+  static QVector<QImage> buildFrames(int size, int count, Colors colors);
+  static QImage noise(int size, int colors, quint32 seed);
+  QByteArray exportGIF(const QVector<QImage> &frames, int scale,
+                       Export::Dither dither, bool parallel);
+  static bool readGIF(const QByteArray &data, QVector<QImage> &frames,
+                      QVector<int> &delays);
+  static int maxDifference(const QImage &a, const QImage &b);
+  static QByteArray header(int width, int height);
+
+  QTemporaryDir scratch;
+};
+
+///
+/// \brief GifTests::buildFrames makes an animation whose left half stays still
+/// while the right half changes every frame, except for one repeated frame,
+/// so that the encoder's deltas and merged repeats are exercised
+/// \param size The canvas side
+/// \param count The number of frames
+/// \param colors The colors of the frames
+/// \return Composites, as the project hands them to the exporter
+///
+QVector<QImage> GifTests::buildFrames(int size, int count, Colors colors) {
+  QVector<QImage> frames;
+  for (int f = 0; f < count; f++) {
+    int time = f == count / 2 ? f - 1 : f;
+    bool few = colors == sprite || (colors == mixed && f % 2 == 0);
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < size; y++) {
+      QRgb *pixels = reinterpret_cast<QRgb *>(image.scanLine(y));
+      for (int x = 0; x < size; x++) {
+        int t = x < size / 2 ? 0 : time;
+        if (few) {
+          int index = (x / 4 + y / 4 + t) % 16;
+          pixels[x] = qRgb(index * 16, 255 - index * 8, (index * 53) & 255);
+        } else {
+          pixels[x] =
+              qRgb((x * 7 + t * 13) & 255, (y * 5 + t) & 255, (x ^ y) & 255);
+        }
+      }
+    }
+    frames.append(image);
+  }
+  return frames;
+}
+
+///
+/// \brief GifTests::noise makes an opaque image of random pixels. Random
+/// pixels rarely repeat a run the lzw dictionary holds, so each adds a code,
+/// and a 256 x 256 image fills the 4096 codes of the dictionary about 16
+/// times over.
+/// \param size The image side
+/// \param colors How many colors the pixels are picked from
+/// \param seed Makes the image repeatable
+/// \return An image like a composite
+///
+QImage GifTests::noise(int size, int colors, quint32 seed) {
+  QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+  for (int y = 0; y < size; y++) {
+    QRgb *pixels = reinterpret_cast<QRgb *>(image.scanLine(y));
+    for (int x = 0; x < size; x++) {
+      seed = seed * 1664525u + 1013904223u; // a linear congruential generator
+      int color = (seed >> 24) % colors;
+      pixels[x] = qRgb(color, 255 - color, (color * 7) & 255);
+    }
+  }
+  return image;
+}
+
+///
+/// \brief GifTests::exportGIF saves frames at 10 frames per second
+/// \param frames
+/// \param scale
+/// \param dither
+/// \param parallel
+/// \return The file written, or nothing if the export failed
+///
+QByteArray GifTests::exportGIF(const QVector<QImage> &frames, int scale,
+                               Export::Dither dither, bool parallel) {
+  QString fileName = scratch.filePath(parallel ? "parallel.gif" : "serial.gif");
+  if (!Export::saveGIF(frames, 10, fileName, scale, dither, parallel)) {
+    return QByteArray();
+  }
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return QByteArray();
+  }
+  return file.readAll();
+}
+
+///
+/// \brief GifTests::readGIF decodes a whole gif
+/// \param data The file
+/// \param frames Set to the canvas after each frame
+/// \param delays Set to each frame's delay, in hundredths of a second
+/// \return false if the file is damaged
+///
+bool GifTests::readGIF(const QByteArray &data, QVector<QImage> &frames,
+                       QVector<int> &delays) {
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+  GifReader reader(&buffer);
+  if (!reader.begin()) {
+    return false;
+  }
+  QImage frame;
+  while (reader.readFrame(frame)) {
+    frames.append(frame);
+    delays.append(reader.delay());
+  }
+  return !reader.failed();
+}
+
+///
+/// \brief GifTests::maxDifference compares two images of the same size
+/// \param a
+/// \param b
+/// \return The largest difference of any color channel of any pixel
+///
+int GifTests::maxDifference(const QImage &a, const QImage &b) {
+  QImage first = a.convertToFormat(QImage::Format_ARGB32);
+  QImage second = b.convertToFormat(QImage::Format_ARGB32);
+  int worst = 0;
+  for (int y = 0; y < first.height(); y++) {
+    const QRgb *pixels = reinterpret_cast<const QRgb *>(first.constScanLine(y));
+    const QRgb *others =
+        reinterpret_cast<const QRgb *>(second.constScanLine(y));
+    for (int x = 0; x < first.width(); x++) {
+      worst = std::max({worst, qAbs(qRed(pixels[x]) - qRed(others[x])),
+                        qAbs(qGreen(pixels[x]) - qGreen(others[x])),
+                        qAbs(qBlue(pixels[x]) - qBlue(others[x]))});
+    }
+  }
+  return worst;
+}
+
+///
+/// \brief GifTests::header makes the start of a gif without a global palette
+/// \param width The canvas width
+/// \param height The canvas height
+/// \return The signature and logical screen descriptor
+///
+QByteArray GifTests::header(int width, int height) {
+  QByteArray data("GIF89a");
+  for (int word : {width, height}) {
+    data.append(char(word & 0xff));
+    data.append(char(word >> 8));
+  }
+  data.append(3, '\0'); // no global palette, background, aspect
+  return data;
+}
+
+void GifTests::roundTrip_data() {
+  QTest::addColumn<int>("colors");
+  QTest::addColumn<int>("scale");
+  QTest::addColumn<int>("tolerance");
+  // Sprites are exact. Quantizing these gradients without dithering moves no
+  // channel by more than about 20.
+  QTest::newRow("sprite") << int(sprite) << 1 << 0;
+  QTest::newRow("sprite scaled") << int(sprite) << 2 << 0;
+  QTest::newRow("gradient") << int(gradient) << 1 << 32;
+  QTest::newRow("gradient scaled") << int(gradient) << 3 << 32;
+  QTest::newRow("mixed") << int(mixed) << 1 << 32;
+}
+
+void GifTests::roundTrip() {
+  QFETCH(int, colors);
+  QFETCH(int, scale);
+  QFETCH(int, tolerance);
+  // Only the right half of later frames changes, so they are written as
+  // rectangles over the frame before, and one repeated frame is merged.
+  QVector<QImage> frames = buildFrames(32, 8, Colors(colors));
+  QVector<QImage> expected;
+  for (int i = 0; i < frames.size(); i++) {
+    if (i == 0 || frames[i] != frames[i - 1]) {
+      expected.append(frames[i]);
+    }
+  }
+  QVector<QImage> shown;
+  QVector<int> delays;
+  QByteArray data = exportGIF(frames, scale, Export::NoDither, true);
+  QVERIFY(readGIF(data, shown, delays));
+  QCOMPARE(shown.size(), expected.size());
+  int total = 0;
+  for (int i = 0; i < shown.size(); i++) {
+    QCOMPARE(shown[i].size(), expected[i].size() * scale);
+    QImage scaled = expected[i].scaled(shown[i].size());
+    QVERIFY2(maxDifference(shown[i], scaled) <= tolerance,
+             qPrintable(QString("frame %1").arg(i)));
+    total += delays[i];
+  }
+  QCOMPARE(total, (int)frames.size() * 10);
+}
+
+void GifTests::truncated() {
+  QVector<QImage> frames = buildFrames(32, 8, sprite);
+  QByteArray data = exportGIF(frames, 1, Export::NoDither, true);
+  QVector<QImage> shown;
+  QVector<int> delays;
+  QVERIFY(readGIF(data, shown, delays));
+  int complete = shown.size();
+
+  for (int size : {8, 20, int(data.size() / 2), int(data.size() - 2)}) {
+    shown.clear();
+    delays.clear();
+    QVERIFY(!readGIF(data.left(size), shown, delays));
+    QVERIFY(shown.size() < complete);
+  }
+}
+
+void GifTests::oversizedScreen() {
+  // 0xffff x 0xffff is 4G pixels, far past maxPixels, so the canvas must be
+  // refused rather than allocated.
+  for (QSize size : {QSize(0xffff, 0xffff), QSize(0, 16), QSize(16, 0)}) {
+    QBuffer buffer;
+    buffer.setData(header(size.width(), size.height()) + "\x3b");
+    buffer.open(QIODevice::ReadOnly);
+    GifReader reader(&buffer);
+    QVERIFY(!reader.begin());
+    QVERIFY(reader.failed());
+  }
+}
+
+void GifTests::descriptor_data() {
+  QTest::addColumn<QRect>("rect");
+  QTest::addColumn<bool>("accepted");
+  QTest::newRow("inside") << QRect(15, 15, 1, 1) << true;
+  QTest::newRow("too wide") << QRect(0, 0, 0xffff, 1) << false;
+  QTest::newRow("too high") << QRect(0, 0, 1, 0xffff) << false;
+  QTest::newRow("past the edge") << QRect(15, 0, 2, 1) << false;
+  QTest::newRow("4G pixels") << QRect(0, 0, 0xffff, 0xffff) << false;
+}
+
+void GifTests::descriptor() {
+  QFETCH(QRect, rect);
+  QFETCH(bool, accepted);
+  // An image descriptor on a 16 x 16 canvas with a 4 color palette and the
+  // lzw codes clear, 0, end. The image must lie on the canvas, and is checked
+  // before the buffer for its pixels is allocated.
+  QByteArray data = header(16, 16);
+  data.append('\x2c');
+  for (int word : {rect.x(), rect.y(), rect.width(), rect.height()}) {
+    data.append(char(word & 0xff));
+    data.append(char(word >> 8));
+  }
+  data.append('\x81');                // local palette of 4 entries
+  data.append(12, '\xff');            // all white
+  data.append("\x02\x02\x44\x01", 4); // min code size, one block of codes
+  data.append("\x00\x3b", 2);         // block terminator, trailer
+
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+  GifReader reader(&buffer);
+  QVERIFY(reader.begin());
+  QImage frame;
+  QCOMPARE(reader.readFrame(frame), accepted);
+  QCOMPARE(reader.failed(), !accepted);
+  if (accepted) {
+    QCOMPARE(frame.pixel(15, 15), qRgb(255, 255, 255));
+  }
+}
+
+void GifTests::serialMatchesParallel_data() {
+  QTest::addColumn<int>("colors");
+  QTest::addColumn<int>("dither");
+  QTest::addColumn<int>("scale");
+  const char *colorNames[] = {"gradient", "sprite", "mixed"};
+  const char *ditherNames[] = {"no dither", "Floyd-Steinberg", "ordered"};
+  for (int colors : {gradient, sprite, mixed}) {
+    for (int dither : {Export::NoDither, Export::FloydSteinberg,
+                       Export::OrderedDither}) {
+      QTest::addRow("%s %s", colorNames[colors], ditherNames[dither])
+          << colors << dither << 1;
+    }
+    QTest::addRow("%s scaled", colorNames[colors]) << colors << 0 << 3;
+  }
+}
+
+void GifTests::serialMatchesParallel() {
+  QFETCH(int, colors);
+  QFETCH(int, dither);
+  QFETCH(int, scale);
+  QVector<QImage> frames = buildFrames(48, 12, Colors(colors));
+  QByteArray serial = exportGIF(frames, scale, Export::Dither(dither), false);
+  QByteArray parallel = exportGIF(frames, scale, Export::Dither(dither), true);
+  QVERIFY(!serial.isEmpty());
+  QCOMPARE(parallel, serial);
+}
+
+void GifTests::longHold() {
+  // At one frame per second, 700 repeats of a frame last longer than the
+  // 0xffff hundredths of a second one gif frame can be shown for.
+  QVector<QImage> frames = buildFrames(8, 1, sprite);
+  frames.fill(frames[0], 700);
+  QVector<QImage> shown;
+  QVector<int> delays;
+  QString fileName = scratch.filePath("hold.gif");
+  QVERIFY(Export::saveGIF(frames, 1, fileName));
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QVERIFY(readGIF(file.readAll(), shown, delays));
+  QCOMPARE((int)delays.size(), 2);
+  QCOMPARE(delays[0] + delays[1], 700 * 100);
+  QCOMPARE(shown[1], shown[0]);
+}
+
+void GifTests::noisyRoundTrip_data() {
+  QTest::addColumn<int>("size");
+  QTest::addColumn<int>("colors");
+  QTest::addColumn<int>("scale");
+  QTest::newRow("256px 200 colors") << 256 << 200 << 1;
+  QTest::newRow("256px 4 colors") << 256 << 4 << 1;
+  QTest::newRow("128px 200 colors scaled") << 128 << 200 << 3;
+}
+
+void GifTests::noisyRoundTrip() {
+  QFETCH(int, size);
+  QFETCH(int, colors);
+  QFETCH(int, scale);
+  // The second frame differs almost everywhere, so it is nearly as large.
+  QVector<QImage> frames = {noise(size, colors, 1), noise(size, colors, 2)};
+  QVector<QImage> shown;
+  QVector<int> delays;
+  QByteArray data = exportGIF(frames, scale, Export::NoDither, true);
+  QVERIFY(readGIF(data, shown, delays));
+  QCOMPARE(shown.size(), frames.size());
+  for (int i = 0; i < frames.size(); i++) {
+    QImage expected = frames[i]
+                          .scaled(size * scale, size * scale)
+                          .convertToFormat(QImage::Format_ARGB32);
+    QCOMPARE(shown[i], expected);
+  }
+}
+
+QTEST_GUILESS_MAIN(GifTests)
+#include "GifTests.moc"
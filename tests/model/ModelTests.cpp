@@ -0,0 +1,239 @@
+#include "Frame.h"
+#include "model.h"
+#include <QMouseEvent>
+#include <QSet>
+#include <QtTest>
+
+///
+/// \brief The ModelTests class checks that the id lookups of the Model follow
+/// every structural edit: frames and layers added, copied, removed, moved,
+/// and brought back or taken away again by undo and redo, without rebuilding
+/// them for edits made through the model. It also checks that painting an
+/// indexed project reuses the palette entries of the conversion.
+///
+class ModelTests : public QObject {
+  Q_OBJECT
+
+private slots:
+  void newProject();
+  void addAndCopyFrames();
+  void removeFrame();
+  void moveFrames();
+  void undoRedoFrames();
+  void layers();
+  void resize();
+  void editsKeepLookups();
+  void translucentPalette();
+
+private:
+  static void verifyLookups(Model &model);
+  static void click(Model &model);
+};
+
+///
+/// \brief ModelTests::verifyLookups checks every frame and layer of the
+/// project can be found by its id, at its current position
+/// \param model
+///
+void ModelTests::verifyLookups(Model &model) {
+  QSet<int> layerIds;
+  for (int i = 0; i < (int)model.frames.size(); i++) {
+    Frame *frame = model.frames[i].get();
+    QCOMPARE(model.indexOfFrame(frame->id), i);
+    QCOMPARE(model.frameById(frame->id), frame);
+    for (const std::unique_ptr<Layer> &layer : frame->layers) {
+      QCOMPARE(model.layerById(layer->id), layer.get());
+      QVERIFY(!layerIds.contains(layer->id));
+      layerIds.insert(layer->id);
+    }
+  }
+}
+
+///
+/// \brief ModelTests::click presses and releases the mouse in the middle of
+/// the editor, as the view delivers it
+/// \param model
+///
+void ModelTests::click(Model &model) {
+  QPointF center(650, 270);
+  QMouseEvent press(QEvent::MouseButtonPress, center, center, Qt::LeftButton,
+                    Qt::LeftButton, Qt::NoModifier);
+  QMouseEvent release(QEvent::MouseButtonRelease, center, center,
+                      Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+  model.mousePressed(&press);
+  model.mouseReleased(&release);
+}
+
+void ModelTests::newProject() {
+  Model model;
+  verifyLookups(model);
+  QCOMPARE(model.indexOfFrame(-1), -1);
+  QVERIFY(!model.frameById(-1));
+  QVERIFY(!model.layerById(-1));
+}
+
+void ModelTests::addAndCopyFrames() {
+  Model model;
+  model.addNewFrameClicked();
+  model.copyFrameClicked();
+  QCOMPARE((int)model.frames.size(), 3);
+  QVERIFY(model.frames[2]->id != model.frames[0]->id);
+  verifyLookups(model);
+}
+
+void ModelTests::removeFrame() {
+  Model model;
+  model.addNewFrameClicked();
+  model.addNewFrameClicked();
+  verifyLookups(model);
+  int removed = model.frames[0]->id;
+  int removedLayer = model.frames[0]->layers[0]->id;
+  model.currentFrameNum = 1;
+  model.removeFrameClicked();
+  QCOMPARE(model.indexOfFrame(removed), -1);
+  QVERIFY(!model.layerById(removedLayer));
+  verifyLookups(model);
+}
+
+void ModelTests::moveFrames() {
+  Model model;
+  model.addNewFrameClicked();
+  model.addNewFrameClicked();
+  int moved = model.frames[0]->id;
+  // Look something up first, so the moves update the fresh lookup in place.
+  verifyLookups(model);
+  model.currentFrameNum = 1;
+  model.moveFrameRightClicked();
+  QCOMPARE(model.indexOfFrame(moved), 1);
+  model.moveFrameRightClicked();
+  QCOMPARE(model.indexOfFrame(moved), 2);
+  model.moveFrameLeftClicked();
+  QCOMPARE(model.indexOfFrame(moved), 1);
+  verifyLookups(model);
+}
+
+void ModelTests::undoRedoFrames() {
+  Model model;
+  model.addNewFrameClicked();
+  model.currentFrameNum = 2;
+  model.currentFrame = model.frames[1].get();
+  Frame *removed = model.currentFrame;
+  int id = removed->id;
+  model.removeFrameClicked();
+  QVERIFY(!model.frameById(id));
+
+  model.undo();
+  QCOMPARE(model.indexOfFrame(id), 1);
+  QCOMPARE(model.frameById(id), removed);
+  verifyLookups(model);
+
+  model.redo();
+  QVERIFY(!model.frameById(id));
+  verifyLookups(model);
+
+  model.moveFrameLeftClicked();
+  model.undo();
+  verifyLookups(model);
+}
+
+void ModelTests::layers() {
+  Model model;
+  model.addBlankLayer();
+  model.addBlankLayer();
+  verifyLookups(model);
+  Frame *frame = model.currentFrame;
+  Layer *top = frame->layers[0].get();
+
+  // Moving layers keeps their addresses.
+  model.setLayerSelect(0);
+  model.moveSelectedLayerDown();
+  QCOMPARE(frame->layers[1].get(), top);
+  QCOMPARE(model.layerById(top->id), top);
+
+  model.setLayerSelect(1);
+  int removed = frame->layers[1]->id;
+  model.deleteSelectedLayer();
+  QVERIFY(!model.layerById(removed));
+  verifyLookups(model);
+
+  model.undo();
+  QCOMPARE(model.layerById(removed), top);
+  verifyLookups(model);
+
+  model.undo();
+  QCOMPARE(frame->layers[0].get(), top);
+  verifyLookups(model);
+}
+
+void ModelTests::resize() {
+  Model model;
+  model.addNewFrameClicked();
+  verifyLookups(model);
+  int old = model.frames[1]->id;
+  model.setSize(16);
+  QCOMPARE(model.indexOfFrame(old), -1);
+  verifyLookups(model);
+}
+
+void ModelTests::editsKeepLookups() {
+  Model model;
+  verifyLookups(model);
+  int rebuilds = model.lookupRebuilds();
+
+  // Looking up every new frame must not rebuild the lookups, which would make
+  // this loop quadratic.
+  for (int i = 0; i < 100; i++) {
+    if (i % 2 == 0) {
+      model.addNewFrameClicked();
+    } else {
+      model.copyFrameClicked();
+    }
+    Frame *added = model.frames.back().get();
+    QCOMPARE(model.indexOfFrame(added->id), i + 1);
+    QCOMPARE(model.layerById(added->layers[0]->id), added->layers[0].get());
+  }
+
+  model.addBlankLayer();
+  Layer *layer = model.currentFrame->layers.back().get();
+  QCOMPARE(model.layerById(layer->id), layer);
+  model.setLayerSelect((int)model.currentFrame->layers.size() - 1);
+  model.deleteSelectedLayer();
+  QVERIFY(!model.layerById(layer->id));
+
+  model.currentFrameNum = 50;
+  model.currentFrame = model.frames[49].get();
+  int removed = model.currentFrame->id;
+  int shifted = model.frames[50]->id;
+  model.removeFrameClicked();
+  QCOMPARE(model.indexOfFrame(removed), -1);
+  QCOMPARE(model.indexOfFrame(shifted), 49);
+  model.moveFrameRightClicked();
+  QCOMPARE(model.indexOfFrame(shifted), 50);
+
+  verifyLookups(model);
+  QCOMPARE(model.lookupRebuilds(), rebuilds);
+
+  // Undo changes frames out of the model's sight, so it rebuilds once.
+  model.undo();
+  verifyLookups(model);
+  QCOMPARE(model.lookupRebuilds(), rebuilds + 1);
+}
+
+void ModelTests::translucentPalette() {
+  // Half alpha doesn't round trip this color exactly through premultiplying.
+  QColor color(201, 99, 53);
+  Model model;
+  model.penButtonClicked();
+  model.colorSelected(color);
+  model.setOpacity(128);
+  click(model);
+  QVERIFY(model.convertToIndexed());
+  int size = model.getPalette().size();
+  QCOMPARE(size, 2);
+
+  click(model);
+  QCOMPARE(model.getPalette().size(), size);
+}
+
+QTEST_GUILESS_MAIN(ModelTests)
+#include "ModelTests.moc"
@@ -0,0 +1,11 @@
+TARGET = modeltests
+
+QT = core gui testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include(../../core/core.pri)
+
+SOURCES += \
+    ModelTests.cpp
@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+# One test executable per directory; "make check" runs them all. Like the core
+# library, they need no display.
+SUBDIRS += \
+    model \
+    gif